@@ -0,0 +1,424 @@
+#include "edge_detector.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Pixels at or below this gradient magnitude are never edges in kThresholdFixed mode
+const int kEdgeThreshold = 30;
+
+// Automatic high thresholds never go below this, so flat or dark frames do not turn
+// sensor noise into edges
+const int kMinAutoThreshold = 8;
+
+// tan(22.5) and tan(67.5) in 1/256 units, used to bin gradient directions without atan2
+const int kTan22_5 = 106;
+const int kTan67_5 = 618;
+
+// Separable form of the 5x5 Gaussian kernel: [1 4 6 4 1]^T * [1 4 6 4 1] / 256
+void gaussianBlurRows(const PaddedImage& input, PaddedImage& output, uint16_t* columnSums, int y0, int y1) {
+    const int width = input.getWidth();
+
+    // Vertical pass for one row, with 2 columns of context on each side
+    uint16_t* sums = columnSums + 2;
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* r0 = input.row(y - 2);
+        const unsigned char* r1 = input.row(y - 1);
+        const unsigned char* r2 = input.row(y);
+        const unsigned char* r3 = input.row(y + 1);
+        const unsigned char* r4 = input.row(y + 2);
+        for (int x = -2; x < width + 2; x++) {
+            sums[x] = (uint16_t)(r0[x] + 4 * (r1[x] + r3[x]) + 6 * r2[x] + r4[x]);
+        }
+
+        unsigned char* out = output.row(y);
+        for (int x = 0; x < width; x++) {
+            int sum = sums[x - 2] + 4 * (sums[x - 1] + sums[x + 1]) + 6 * sums[x] + sums[x + 2];
+            out[x] = (unsigned char)(sum >> 8);
+        }
+    }
+}
+
+void downsampleRows(const PaddedImage& input, PaddedImage& output, int y0, int y1) {
+    const int width = output.getWidth();
+
+    // Odd input sizes read one pixel into the replicated border
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* r0 = input.row(2 * y);
+        const unsigned char* r1 = input.row(2 * y + 1);
+        unsigned char* out = output.row(y);
+        for (int x = 0; x < width; x++) {
+            out[x] = (unsigned char)((r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1] + 2) >> 2);
+        }
+    }
+}
+
+void sobelGradientRows(const PaddedImage& input, PaddedImage& magnitude, PaddedImage& direction, int y0, int y1,
+                       uint32_t* histogram) {
+    const int width = input.getWidth();
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* r0 = input.row(y - 1);
+        const unsigned char* r1 = input.row(y);
+        const unsigned char* r2 = input.row(y + 1);
+        unsigned char* mag = magnitude.row(y);
+        unsigned char* dir = direction.row(y);
+
+        for (int x = 0; x < width; x++) {
+            int gradientX = (r0[x + 1] - r0[x - 1]) + 2 * (r1[x + 1] - r1[x - 1]) + (r2[x + 1] - r2[x - 1]);
+            int gradientY = (r2[x - 1] + 2 * r2[x] + r2[x + 1]) - (r0[x - 1] + 2 * r0[x] + r0[x + 1]);
+
+            float m = std::sqrt((float)(gradientX * gradientX + gradientY * gradientY));
+            mag[x] = (unsigned char)std::min(m, 255.0f);
+
+            // Image y grows downwards, so a gradient with gx and gy of the same sign
+            // points along the up-left/down-right diagonal
+            int absX = std::abs(gradientX);
+            int absY = std::abs(gradientY);
+            int diagonal = ((gradientX ^ gradientY) >= 0) ? kDirectionDiagonal : kDirectionAntiDiagonal;
+            int vertical = (absY * 256 >= absX * kTan67_5) ? kDirectionVertical : diagonal;
+            dir[x] = (unsigned char)((absY * 256 <= absX * kTan22_5) ? kDirectionHorizontal : vertical);
+        }
+
+        // Count the row while it is still in L1; kept out of the loop above so that one
+        // stays vectorizable. A quarter of the pixels is plenty for a 256-bin histogram.
+        if (histogram != nullptr && (y & 1) == 0) {
+            for (int x = 0; x < width; x += 2) {
+                histogram[mag[x] * kHistogramLanes + ((x >> 1) & (kHistogramLanes - 1))]++;
+            }
+        }
+    }
+}
+
+namespace {
+
+// Larger of the two neighbours along the gradient direction at x, and the largest of all
+// eight. Evaluates all four neighbour pairs and selects, rather than branching on direction.
+inline void neighborMaxima(const unsigned char* m0, const unsigned char* m1, const unsigned char* m2,
+                           int x, int d, int& along, int& strongest) {
+    int horizontal = std::max(m1[x - 1], m1[x + 1]);
+    int vertical = std::max(m0[x], m2[x]);
+    int diagonal = std::max(m0[x - 1], m2[x + 1]);
+    int antiDiagonal = std::max(m0[x + 1], m2[x - 1]);
+    along = d == kDirectionHorizontal ? horizontal
+          : d == kDirectionVertical ? vertical
+          : d == kDirectionDiagonal ? diagonal : antiDiagonal;
+    strongest = std::max(std::max(horizontal, vertical), std::max(diagonal, antiDiagonal));
+}
+
+// Enhanced contrast (x1.5) for edges that survive suppression
+inline int enhanceEdge(int magnitude) {
+    return std::min((magnitude * 3) >> 1, 255);
+}
+
+} // namespace
+
+void suppressNonMaximaRows(const PaddedImage& magnitude, const PaddedImage& direction, EdgeThresholds thresholds,
+                           unsigned char* output, ptrdiff_t outputStride, int y0, int y1) {
+    const int width = magnitude.getWidth();
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* m0 = magnitude.row(y - 1);
+        const unsigned char* m1 = magnitude.row(y);
+        const unsigned char* m2 = magnitude.row(y + 1);
+        const unsigned char* dir = direction.row(y);
+        unsigned char* out = output + y * outputStride;
+
+        for (int x = 0; x < width; x++) {
+            int neighbor, strongest;
+            neighborMaxima(m0, m1, m2, x, dir[x], neighbor, strongest);
+
+            // Weak maxima survive only next to a strong pixel
+            int mag = m1[x];
+            bool strong = mag >= thresholds.high;
+            bool weak = mag >= thresholds.low && strongest >= thresholds.high;
+            out[x] = (unsigned char)((mag >= neighbor && (strong || weak)) ? enhanceEdge(mag) : 0);
+        }
+    }
+}
+
+EdgeThresholds thresholdsFromHistogram(const uint32_t* histogram, ThresholdMode mode, float percentile) {
+    uint64_t total = 0;
+    double weightedTotal = 0.0;
+    for (int i = 0; i < kHistogramBins; i++) {
+        total += histogram[i];
+        weightedTotal += (double)i * histogram[i];
+    }
+
+    int high = kEdgeThreshold + 1;
+    if (total > 0 && mode == kThresholdOtsu) {
+        // Split that maximizes the between-class variance; magnitudes above it are edges
+        uint64_t below = 0;
+        double weightedBelow = 0.0;
+        double bestVariance = -1.0;
+        for (int t = 0; t < kHistogramBins - 1; t++) {
+            below += histogram[t];
+            weightedBelow += (double)t * histogram[t];
+            uint64_t above = total - below;
+            if (below == 0) continue;
+            if (above == 0) break;
+            double meanDifference = weightedBelow / below - (weightedTotal - weightedBelow) / above;
+            double variance = (double)below * (double)above * meanDifference * meanDifference;
+            if (variance > bestVariance) {
+                bestVariance = variance;
+                high = t + 1;
+            }
+        }
+    } else if (total > 0 && mode == kThresholdPercentile) {
+        // NaN would slip through the clamp; EdgeDetector filters it, other callers get 100
+        float clamped = std::isnan(percentile) ? 100.0f : std::min(std::max(percentile, 0.0f), 100.0f);
+        uint64_t target = (uint64_t)(total * (double)clamped / 100.0);
+        uint64_t cumulative = 0;
+        for (int t = 0; t < kHistogramBins; t++) {
+            cumulative += histogram[t];
+            if (cumulative >= target) {
+                high = t + 1;
+                break;
+            }
+        }
+    }
+
+    if (mode == kThresholdFixed) {
+        return {high, high};
+    }
+    high = std::min(std::max(high, kMinAutoThreshold), 255);
+    return {high / 2, high};
+}
+
+EdgeDetector::EdgeDetector() : workerPool(nullptr), settings{1, kMergeMax, kThresholdFixed, 90.0f},
+                               lastThresholds{kEdgeThreshold + 1, kEdgeThreshold + 1} {
+}
+
+void EdgeDetector::setThresholdMode(ThresholdMode mode, float percentile) {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    settings.thresholdMode = mode;
+    // The value comes straight from JNI; a NaN would pass the clamp below and reach an
+    // undefined float-to-integer conversion, so keep the previous percentile instead
+    if (std::isfinite(percentile)) {
+        settings.thresholdPercentile = std::min(std::max(percentile, 0.0f), 100.0f);
+    }
+}
+
+void EdgeDetector::setScaleLevels(int levels, ScaleMergeMode mergeMode) {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    settings.scaleLevels = std::min(std::max(levels, 1), kMaxScaleLevels);
+    settings.mergeMode = mergeMode;
+}
+
+void EdgeDetector::process(const unsigned char* input, ptrdiff_t inputStride,
+                           unsigned char* output, ptrdiff_t outputStride, int width, int height) {
+    // One consistent set of settings for the whole frame, even if a setter runs meanwhile
+    Settings frameSettings;
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        frameSettings = settings;
+    }
+
+    // Stop halving before a level gets too small for the 3x3 kernels to mean anything
+    int levelCount = 1;
+    while (levelCount < frameSettings.scaleLevels && std::min(width, height) >> levelCount >= 8) {
+        levelCount++;
+    }
+
+    source.reset(width, height, 2);
+    for (int k = 0; k < levelCount; k++) {
+        int levelWidth = (width + (1 << k) - 1) >> k;
+        int levelHeight = (height + (1 << k) - 1) >> k;
+        levels[k].image.reset(levelWidth, levelHeight, 1);
+        levels[k].magnitude.reset(levelWidth, levelHeight, 1);
+        levels[k].direction.reset(levelWidth, levelHeight, 0);
+        if (k > 0) {
+            levels[k].support.reset(levelWidth, levelHeight, 0);
+        }
+    }
+
+    source.copyFrom(input, inputStride);
+    source.replicateBorders();
+
+    // Step 1: Apply Gaussian blur to reduce noise
+    int threads = workerPool != nullptr ? workerPool->getThreadCount() : 1;
+    size_t scratchRow = (size_t)width + 4;
+    if (blurScratch.size() < scratchRow * threads) {
+        blurScratch.resize(scratchRow * threads);
+    }
+    buildBands(0, 0);
+    runBands([&](const RowBand& band, int worker) {
+        gaussianBlurRows(source, levels[0].image, &blurScratch[scratchRow * worker], band.y0, band.y1);
+    });
+    levels[0].image.replicateBorders();
+
+    // Step 2: Halve the blurred frame into the coarser levels
+    for (int k = 1; k < levelCount; k++) {
+        buildBands(k, k);
+        runBands([&](const RowBand& band, int /* worker */) {
+            downsampleRows(levels[band.level - 1].image, levels[band.level].image, band.y0, band.y1);
+        });
+        levels[k].image.replicateBorders();
+    }
+
+    // Step 3: Sobel gradients, all levels at once. Automatic thresholds also count
+    // magnitudes into a private histogram per worker and level, so no locking is needed.
+    bool autoThreshold = frameSettings.thresholdMode != kThresholdFixed;
+    if (autoThreshold) {
+        histograms.assign((size_t)threads * levelCount * kHistogramSize, 0);
+    }
+    buildBands(0, levelCount - 1);
+    runBands([&](const RowBand& band, int worker) {
+        Level& level = levels[band.level];
+        uint32_t* histogram = autoThreshold
+                ? &histograms[((size_t)worker * levelCount + band.level) * kHistogramSize] : nullptr;
+        sobelGradientRows(level.image, level.magnitude, level.direction, band.y0, band.y1, histogram);
+    });
+    for (int k = 0; k < levelCount; k++) {
+        levels[k].magnitude.replicateBorders();
+
+        if (!autoThreshold) {
+            levels[k].thresholds = {kEdgeThreshold + 1, kEdgeThreshold + 1};
+            continue;
+        }
+
+        // Fold the lanes and per-worker copies together, then pick this frame's thresholds
+        uint32_t merged[kHistogramBins] = {};
+        for (int worker = 0; worker < threads; worker++) {
+            const uint32_t* histogram = &histograms[((size_t)worker * levelCount + k) * kHistogramSize];
+            for (int i = 0; i < kHistogramSize; i++) {
+                merged[i / kHistogramLanes] += histogram[i];
+            }
+        }
+        levels[k].thresholds = thresholdsFromHistogram(merged, frameSettings.thresholdMode,
+                                                      frameSettings.thresholdPercentile);
+    }
+    lastThresholds = levels[0].thresholds;
+
+    // Step 4: Non-maximum suppression for thinner edges
+    if (levelCount == 1) {
+        buildBands(0, 0);
+        runBands([&](const RowBand& band, int /* worker */) {
+            suppressNonMaximaRows(levels[0].magnitude, levels[0].direction, levels[0].thresholds,
+                                  output, outputStride, band.y0, band.y1);
+        });
+        return;
+    }
+
+    // Collect the coarse levels' strong responses, coarsest first, so each level is
+    // upsampled only one step and only level 1 is read at full resolution
+    for (int k = levelCount - 1; k >= 1; k--) {
+        buildBands(k, k);
+        runBands([&](const RowBand& band, int /* worker */) {
+            foldSupportRows(band.level, levelCount, frameSettings.mergeMode, band.y0, band.y1);
+        });
+    }
+    buildBands(0, 0);
+    runBands([&](const RowBand& band, int /* worker */) {
+        suppressWithSupportRows(levelCount, frameSettings.mergeMode, output, outputStride, band.y0, band.y1);
+    });
+}
+
+// Splits the rows of levels [firstLevel, lastLevel] into bands of similar size, so coarse
+// levels share the workers with level 0 instead of waiting for it
+void EdgeDetector::buildBands(int firstLevel, int lastLevel) {
+    int threads = workerPool != nullptr ? workerPool->getThreadCount() : 1;
+    int fullHeight = levels[0].image.getHeight();
+    int rowsPerBand = threads > 1 ? std::max(16, fullHeight / (threads * 4)) : fullHeight;
+
+    bands.clear();
+    for (int k = firstLevel; k <= lastLevel; k++) {
+        int levelHeight = levels[k].image.getHeight();
+        for (int y = 0; y < levelHeight; y += rowsPerBand) {
+            bands.push_back({k, y, std::min(levelHeight, y + rowsPerBand)});
+        }
+    }
+}
+
+template <typename Kernel>
+void EdgeDetector::runBands(const Kernel& kernel) {
+    if (workerPool == nullptr || bands.size() == 1) {
+        for (const RowBand& band : bands) {
+            kernel(band, 0);
+        }
+        return;
+    }
+    workerPool->parallelFor((int)bands.size(), [&](int index, int worker) {
+        kernel(bands[index], worker);
+    });
+}
+
+void EdgeDetector::foldSupportRows(int k, int levelCount, ScaleMergeMode mergeMode, int y0, int y1) {
+    Level& level = levels[k];
+    const int width = level.support.getWidth();
+    const int high = level.thresholds.high;
+    const bool coarsest = k == levelCount - 1;
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* mag = level.magnitude.row(y);
+        const unsigned char* coarser = coarsest ? nullptr : levels[k + 1].support.row(y >> 1);
+        unsigned char* out = level.support.row(y);
+
+        // Nearest-neighbour upsampling: coarser pixel x feeds pixels 2x and 2x + 1
+        auto foldPixel = [&](int i, int coarserIndex) {
+            int below = coarsest ? 0 : coarser[coarserIndex];
+            if (mergeMode == kMergeMax) {
+                out[i] = (unsigned char)std::max(mag[i] >= high ? enhanceEdge(mag[i]) : 0, below);
+            } else {
+                out[i] = (unsigned char)((mag[i] >= high) + below);
+            }
+        };
+        const int pairs = width / 2;
+        for (int x = 0; x < pairs; x++) {
+            foldPixel(2 * x, x);
+            foldPixel(2 * x + 1, x);
+        }
+        if (width & 1) {
+            foldPixel(width - 1, pairs);
+        }
+    }
+}
+
+// Non-maximum suppression on level 0 where coarse support can stand in for the fine
+// thresholds. A supported maximum still needs half the low threshold, so flat areas
+// next to a strong coarse response are not filled with noise maxima.
+void EdgeDetector::suppressWithSupportRows(int levelCount, ScaleMergeMode mergeMode,
+                                           unsigned char* output, ptrdiff_t outputStride, int y0, int y1) {
+    const Level& level = levels[0];
+    const int width = level.magnitude.getWidth();
+    const EdgeThresholds thresholds = level.thresholds;
+    // Both modes as one branch-free rule: max merging is a vote that needs one level, with
+    // the support magnitude counting as one vote and also feeding the output value
+    const bool maxMerge = mergeMode == kMergeMax;
+    const int minVotes = maxMerge ? 1 : levelCount / 2 + 1;
+    const int voteCap = maxMerge ? 1 : kMaxScaleLevels;
+    const int valueCap = maxMerge ? 255 : 0;
+
+    for (int y = y0; y < y1; y++) {
+        const unsigned char* m0 = level.magnitude.row(y - 1);
+        const unsigned char* m1 = level.magnitude.row(y);
+        const unsigned char* m2 = level.magnitude.row(y + 1);
+        const unsigned char* dir = level.direction.row(y);
+        const unsigned char* support = levels[1].support.row(y >> 1);
+        unsigned char* out = output + y * outputStride;
+
+        auto suppressPixel = [&](int x, int supportIndex) {
+            int neighbor, strongest;
+            neighborMaxima(m0, m1, m2, x, dir[x], neighbor, strongest);
+            int mag = m1[x];
+            bool strong = mag >= thresholds.high;
+            bool weak = mag >= thresholds.low && strongest >= thresholds.high;
+            int coarse = support[supportIndex];
+            int votes = (strong || weak) + std::min(coarse, voteCap);
+            int value = std::max(enhanceEdge(mag), std::min(coarse, valueCap));
+            bool keep = mag >= neighbor && 2 * mag >= thresholds.low && votes >= minVotes;
+            out[x] = (unsigned char)(keep ? value : 0);
+        };
+        const int pairs = width / 2;
+        for (int x = 0; x < pairs; x++) {
+            suppressPixel(2 * x, x);
+            suppressPixel(2 * x + 1, x);
+        }
+        if (width & 1) {
+            suppressPixel(width - 1, pairs);
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#ifndef EDGEDETECTION_EDGE_DETECTOR_H
+#define EDGEDETECTION_EDGE_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "padded_image.h"
+
+class WorkerPool;
+
+// Edge detection kernels shared by the JNI layer and the host-side tools.
+//
+// Kernels work on PaddedImages whose borders have already been filled, so the same
+// branch-free inner loop runs for every pixel, including the frame edges. Each kernel
+// processes the row range [y0, y1), which lets callers split a frame across threads.
+
+// Rows of context single-scale EdgeDetector::process needs on each side of an output row:
+// 2 for the 5x5 blur, 1 for the Sobel kernels and 1 for non-maximum suppression
+const int kEdgePipelineHalo = 4;
+
+// Quantized gradient directions stored by sobelGradientRows
+enum GradientDirection : unsigned char {
+    kDirectionHorizontal = 0,   // compare with left/right neighbours
+    kDirectionVertical = 1,     // compare with up/down neighbours
+    kDirectionDiagonal = 2,     // compare with up-left/down-right neighbours
+    kDirectionAntiDiagonal = 3, // compare with up-right/down-left neighbours
+};
+
+// Gradient magnitude histogram filled by sobelGradientRows. Each bin is split into
+// kHistogramLanes interleaved counters (index = bin * kHistogramLanes + x % kHistogramLanes)
+// so consecutive pixels with the same magnitude do not serialize on one counter.
+const int kHistogramBins = 256;
+const int kHistogramLanes = 4;
+const int kHistogramSize = kHistogramBins * kHistogramLanes;
+
+// Suppression keeps local maxima with magnitude >= high, and those with magnitude >= low
+// that touch a pixel >= high. low == high gives a single hard threshold.
+struct EdgeThresholds {
+    int low;
+    int high;
+};
+
+// How EdgeDetector picks thresholds for each frame
+enum ThresholdMode {
+    kThresholdFixed = 0,      // the historical magnitude > 30
+    kThresholdOtsu = 1,       // Otsu split of the frame's magnitude histogram
+    kThresholdPercentile = 2, // high = given percentile of the frame's magnitudes
+};
+
+// Derives low/high thresholds from a merged kHistogramBins histogram
+EdgeThresholds thresholdsFromHistogram(const uint32_t* histogram, ThresholdMode mode, float percentile);
+
+// 5x5 Gaussian blur to reduce noise. `input` needs a border of at least 2.
+// `columnSums` is scratch space for width + 4 values, one buffer per concurrent caller.
+void gaussianBlurRows(const PaddedImage& input, PaddedImage& output, uint16_t* columnSums, int y0, int y1);
+
+// 2x2 box downsample for the scale pyramid; `output` is ceil(width/2) x ceil(height/2)
+// and `input` needs a border of at least 1.
+void downsampleRows(const PaddedImage& input, PaddedImage& output, int y0, int y1);
+
+// Sobel gradient magnitude (clamped to 255) and quantized direction.
+// `input` needs a border of at least 1. When `histogram` is set, magnitudes of every
+// second pixel on even rows are also counted into it (kHistogramSize entries, accumulated).
+void sobelGradientRows(const PaddedImage& input, PaddedImage& magnitude, PaddedImage& direction, int y0, int y1,
+                       uint32_t* histogram = nullptr);
+
+// Keeps pixels that are local maxima along their gradient direction and pass `thresholds`,
+// with enhanced contrast. `magnitude` needs a border of at least 1.
+void suppressNonMaximaRows(const PaddedImage& magnitude, const PaddedImage& direction, EdgeThresholds thresholds,
+                           unsigned char* output, ptrdiff_t outputStride, int y0, int y1);
+
+// How coarse pyramid levels take part in the full-resolution edge decision
+enum ScaleMergeMode {
+    kMergeMax = 0,  // any level with a strong response is enough; strongest response is kept
+    kMergeVote = 1, // edge only where a majority of levels agree
+};
+
+const int kMaxScaleLevels = 4;
+
+// Full pipeline used by processFrameData: blur, Sobel, then non-maximum suppression.
+// Keeps its intermediate images between calls, so reuse one instance per frame stream.
+//
+// With more than one scale level the blurred frame is repeatedly halved into a pyramid and
+// gradients run on every level. Non-maximum suppression still runs once, at full
+// resolution: coarse levels only decide which full-resolution maxima count as edges, so
+// edges stay as thin as single-scale ones and where level 0 puts them. Coarse levels add
+// 1/4 + 1/16 + ... of the single-scale gradient work.
+class EdgeDetector {
+public:
+    EdgeDetector();
+
+    // Rows of every stage are split across `pool` when set; otherwise runs on the caller
+    void setWorkerPool(WorkerPool* pool) { workerPool = pool; }
+    // The settings below may be changed from any thread; they take effect from the next
+    // frame, never in the middle of one.
+    // 1 = single scale (default); clamped to [1, kMaxScaleLevels]
+    void setScaleLevels(int levels, ScaleMergeMode mergeMode);
+    // Automatic modes build the histogram inside the gradient pass and apply the result to
+    // the same frame's suppression; `percentile` (0-100) is used by kThresholdPercentile
+    void setThresholdMode(ThresholdMode mode, float percentile = 90.0f);
+    // Thresholds applied to the full-resolution level of the last frame
+    EdgeThresholds getLastThresholds() const { return lastThresholds; }
+
+    void process(const unsigned char* input, ptrdiff_t inputStride,
+                 unsigned char* output, ptrdiff_t outputStride, int width, int height);
+
+private:
+    struct Level {
+        PaddedImage image;
+        PaddedImage magnitude;
+        PaddedImage direction;
+        // Coarse levels only: strong responses of this and all coarser levels, upsampled to
+        // this level. Strongest enhanced magnitude with kMergeMax, level count with kMergeVote.
+        PaddedImage support;
+        EdgeThresholds thresholds;
+    };
+
+    struct RowBand {
+        int level;
+        int y0;
+        int y1;
+    };
+
+    struct Settings {
+        int scaleLevels;
+        ScaleMergeMode mergeMode;
+        ThresholdMode thresholdMode;
+        float thresholdPercentile;
+    };
+
+    WorkerPool* workerPool;
+    // Written by the setters, copied once at the start of each frame
+    std::mutex settingsMutex;
+    Settings settings;
+    EdgeThresholds lastThresholds;
+
+    PaddedImage source;
+    Level levels[kMaxScaleLevels];
+    std::vector<RowBand> bands;
+    // gaussianBlurRows scratch, one row of column sums per worker
+    std::vector<uint16_t> blurScratch;
+    // One kHistogramSize histogram per worker and level, merged after the gradient pass
+    std::vector<uint32_t> histograms;
+
+    void buildBands(int firstLevel, int lastLevel);
+    template <typename Kernel>
+    void runBands(const Kernel& kernel);
+    void foldSupportRows(int k, int levelCount, ScaleMergeMode mergeMode, int y0, int y1);
+    void suppressWithSupportRows(int levelCount, ScaleMergeMode mergeMode,
+                                 unsigned char* output, ptrdiff_t outputStride, int y0, int y1);
+};
+
+#endif // EDGEDETECTION_EDGE_DETECTOR_H
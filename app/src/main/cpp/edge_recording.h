@@ -0,0 +1,132 @@
+#ifndef EDGEDETECTION_EDGE_RECORDING_H
+#define EDGEDETECTION_EDGE_RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+
+// On-disk layout of an edge recording (.edgr) file. All fields are little-endian.
+//
+//   RecordingFileHeader
+//   RecordingFrameHeader + payload   (repeated, one per frame)
+//   RecordingIndexEntry[frameCount]  (written when the recording is closed)
+//
+// The file header is rewritten on close with the frame count and the offset of the
+// index, so a reader can seek straight to any frame. A recording that was never
+// closed has indexOffset == 0 and can still be read by walking the frame headers.
+
+static const char kRecordingFileMagic[4] = {'E', 'D', 'G', 'R'};
+static const char kRecordingFrameMagic[4] = {'F', 'R', 'M', 'E'};
+static const uint32_t kRecordingVersion = 1;
+
+enum RecordingEncoding : uint32_t {
+    // Run-length encoded edge map, see encodeEdgeRle()
+    kEncodingEdgeRle = 1,
+    // Uncompressed 8-bit plane, `stride` bytes per row
+    kEncodingRaw = 2,
+};
+
+#pragma pack(push, 1)
+struct RecordingFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameCount;
+    uint64_t indexOffset;
+};
+
+struct RecordingFrameHeader {
+    char magic[4];
+    uint32_t encoding;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t payloadSize;
+    int64_t timestampNs;
+};
+
+struct RecordingIndexEntry {
+    uint64_t offset;
+    int64_t timestampNs;
+};
+#pragma pack(pop)
+
+// Upper bound of encodeEdgeRle() output for `pixelCount` pixels
+inline size_t edgeRleBound(size_t pixelCount) {
+    return pixelCount + pixelCount / 2 + 16;
+}
+
+inline uint8_t* writeVarint(uint8_t* out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+inline const uint8_t* readVarint(const uint8_t* in, const uint8_t* end, uint32_t* value) {
+    uint32_t result = 0;
+    int shift = 0;
+    while (in < end && shift < 35) {
+        uint8_t byte = *in++;
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return in;
+        }
+        shift += 7;
+    }
+    return nullptr;
+}
+
+// Edge maps are mostly zero, so they are stored as a sequence of
+// (zero run length, literal count, literal bytes...) tokens.
+// Returns the number of bytes written to `out`, which must hold edgeRleBound(pixelCount).
+inline size_t encodeEdgeRle(const uint8_t* pixels, size_t pixelCount, uint8_t* out) {
+    uint8_t* cursor = out;
+    size_t i = 0;
+    while (i < pixelCount) {
+        size_t zeroStart = i;
+        while (i < pixelCount && pixels[i] == 0) {
+            i++;
+        }
+        size_t literalStart = i;
+        while (i < pixelCount && pixels[i] != 0) {
+            i++;
+        }
+        size_t literalCount = i - literalStart;
+        cursor = writeVarint(cursor, (uint32_t)(literalStart - zeroStart));
+        cursor = writeVarint(cursor, (uint32_t)literalCount);
+        for (size_t k = 0; k < literalCount; k++) {
+            *cursor++ = pixels[literalStart + k];
+        }
+    }
+    return (size_t)(cursor - out);
+}
+
+// Returns false if the payload is malformed or does not cover exactly `pixelCount` pixels
+inline bool decodeEdgeRle(const uint8_t* data, size_t size, uint8_t* pixels, size_t pixelCount) {
+    const uint8_t* cursor = data;
+    const uint8_t* end = data + size;
+    size_t i = 0;
+    while (cursor < end) {
+        uint32_t zeroRun = 0;
+        uint32_t literalCount = 0;
+        cursor = readVarint(cursor, end, &zeroRun);
+        if (cursor == nullptr) return false;
+        cursor = readVarint(cursor, end, &literalCount);
+        if (cursor == nullptr) return false;
+        if (zeroRun > pixelCount - i || literalCount > pixelCount - i - zeroRun) return false;
+        if ((size_t)(end - cursor) < literalCount) return false;
+        for (uint32_t k = 0; k < zeroRun; k++) {
+            pixels[i++] = 0;
+        }
+        for (uint32_t k = 0; k < literalCount; k++) {
+            pixels[i++] = *cursor++;
+        }
+    }
+    return i == pixelCount;
+}
+
+#endif // EDGEDETECTION_EDGE_RECORDING_H
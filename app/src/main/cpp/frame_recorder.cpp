@@ -0,0 +1,295 @@
+#include "frame_recorder.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "FrameRecorder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+FrameRecorder::FrameRecorder() : file(nullptr), indexFile(nullptr), indexValid(false), fileBroken(false),
+                                 frameWidth(0), frameHeight(0), frameStride(0),
+                                 frameEncoding(kEncodingEdgeRle),
+                                 readyHead(0), readyCount(0), submitsInFlight(0), stopRequested(false),
+                                 running(false), framesWritten(0), framesDropped(0), writeOffset(0) {
+}
+
+FrameRecorder::~FrameRecorder() {
+    stop();
+}
+
+bool FrameRecorder::start(const std::string& path, int width, int height, int stride, int queueDepth, RecordingEncoding encoding) {
+    // Held until the writer is running, so a concurrent stop() cannot see half a start
+    std::lock_guard<std::mutex> lifecycleLock(lifecycleMutex);
+    if (running.load()) {
+        LOGE("Recording already in progress");
+        return false;
+    }
+    if (width <= 0 || height <= 0 || stride < width || queueDepth <= 0) {
+        LOGE("Invalid recording parameters: %dx%d (stride %d), queue depth %d", width, height, stride, queueDepth);
+        return false;
+    }
+
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        LOGE("Failed to open recording file: %s", path.c_str());
+        return false;
+    }
+    indexPath = path + ".idx";
+    indexFile = fopen(indexPath.c_str(), "w+b");
+    if (indexFile == nullptr) {
+        LOGE("Failed to open recording index: %s", indexPath.c_str());
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+    indexValid = true;
+    fileBroken = false;
+
+    frameWidth = width;
+    frameHeight = height;
+    frameStride = stride;
+    frameEncoding = encoding;
+
+    // Preallocate everything up front so the camera thread never allocates
+    size_t pixelCount = (size_t)stride * height;
+    slots.assign(queueDepth, Slot());
+    freeSlots.clear();
+    freeSlots.reserve(queueDepth);
+    for (int i = 0; i < queueDepth; i++) {
+        slots[i].pixels.resize(pixelCount);
+        slots[i].timestampNs = 0;
+        freeSlots.push_back(i);
+    }
+    readySlots.assign(queueDepth, -1);
+    readyHead = 0;
+    readyCount = 0;
+    submitsInFlight = 0;
+    stopRequested = false;
+    encodeBuffer.resize(edgeRleBound(pixelCount));
+    framesWritten = 0;
+    framesDropped = 0;
+
+    RecordingFileHeader header = {};
+    memcpy(header.magic, kRecordingFileMagic, sizeof(header.magic));
+    header.version = kRecordingVersion;
+    header.width = (uint32_t)width;
+    header.height = (uint32_t)height;
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        LOGE("Failed to write recording header");
+        fclose(file);
+        file = nullptr;
+        fclose(indexFile);
+        indexFile = nullptr;
+        remove(indexPath.c_str());
+        return false;
+    }
+    writeOffset = sizeof(header);
+
+    running.store(true, std::memory_order_release);
+    writerThread = std::thread(&FrameRecorder::writerLoop, this);
+
+    LOGI("Recording started: %s (%dx%d, %d slots)", path.c_str(), width, height, queueDepth);
+    return true;
+}
+
+void FrameRecorder::stop() {
+    // Held until the file is closed, so start() cannot reuse the file, slots or writer
+    // thread while they are still being torn down
+    std::lock_guard<std::mutex> lifecycleLock(lifecycleMutex);
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (!running.load()) {
+            return;
+        }
+        running.store(false, std::memory_order_release);
+        // Let submitters that already own a slot finish their copy
+        queueCondition.wait(lock, [this] { return submitsInFlight == 0; });
+        stopRequested = true;
+    }
+    queueCondition.notify_all();
+
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    finishFile();
+
+    // Nothing can reference the slots any more; give the memory back until the next start()
+    slots.clear();
+    slots.shrink_to_fit();
+    encodeBuffer.clear();
+    encodeBuffer.shrink_to_fit();
+
+    LOGI("Recording stopped: %u frames written, %u dropped", framesWritten.load(), framesDropped.load());
+}
+
+bool FrameRecorder::submitFrame(const uint8_t* data, int width, int height, int stride, int64_t timestampNs) {
+    if (!running.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    int slotIndex;
+    {
+        // Re-check under the lock: a caller that passed the check above can get here after
+        // stop() and a new start() with a different frame size
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!running.load()) {
+            return false;
+        }
+        if (width != frameWidth || height != frameHeight || stride != frameStride || freeSlots.empty()) {
+            // Wrong frame size, or the writer is behind: drop rather than wait
+            framesDropped++;
+            return false;
+        }
+        slotIndex = freeSlots.back();
+        freeSlots.pop_back();
+        submitsInFlight++;
+    }
+
+    // Copy outside the lock; the slot is owned by this thread until it is queued
+    Slot& slot = slots[slotIndex];
+    uint8_t* dst = slot.pixels.data();
+    if (stride == width) {
+        memcpy(dst, data, (size_t)width * height);
+    } else {
+        // Camera planes may end right after the last visible pixel, so copy row by row
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + (size_t)y * stride, data + (size_t)y * stride, width);
+        }
+    }
+    slot.timestampNs = timestampNs;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        readySlots[(readyHead + readyCount) % readySlots.size()] = slotIndex;
+        readyCount++;
+        submitsInFlight--;
+    }
+    queueCondition.notify_all();
+    return true;
+}
+
+void FrameRecorder::writerLoop() {
+    while (true) {
+        int slotIndex;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return readyCount > 0 || stopRequested; });
+            if (readyCount == 0) {
+                // Stop requested and the queue is drained
+                return;
+            }
+            slotIndex = readySlots[readyHead];
+            readyHead = (readyHead + 1) % readySlots.size();
+            readyCount--;
+        }
+
+        if (!writeFrame(slots[slotIndex], slotIndex) && !fileBroken) {
+            LOGE("Failed to write frame, dropping it");
+        }
+    }
+}
+
+bool FrameRecorder::writeFrame(Slot& slot, int slotIndex) {
+    size_t pixelCount = (size_t)frameStride * frameHeight;
+
+    RecordingFrameHeader header = {};
+    memcpy(header.magic, kRecordingFrameMagic, sizeof(header.magic));
+    header.width = (uint32_t)frameWidth;
+    header.height = (uint32_t)frameHeight;
+    header.stride = (uint32_t)frameStride;
+    header.timestampNs = slot.timestampNs;
+
+    // Encode into the writer's own buffer so the slot can be recycled before the disk write
+    size_t payloadSize = 0;
+    if (frameEncoding == kEncodingEdgeRle && frameStride == frameWidth) {
+        payloadSize = encodeEdgeRle(slot.pixels.data(), pixelCount, encodeBuffer.data());
+    }
+    if (payloadSize == 0 || payloadSize >= pixelCount) {
+        // Raw requested, or the frame was too busy for RLE to pay off
+        header.encoding = kEncodingRaw;
+        payloadSize = pixelCount;
+        memcpy(encodeBuffer.data(), slot.pixels.data(), pixelCount);
+    } else {
+        header.encoding = kEncodingEdgeRle;
+    }
+    header.payloadSize = (uint32_t)payloadSize;
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        freeSlots.push_back(slotIndex);
+    }
+
+    if (fileBroken) {
+        framesDropped++;
+        return false;
+    }
+    // Flushed per frame so a failure is reported for the frame it hit, not a later one
+    if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fwrite(encodeBuffer.data(), 1, payloadSize, file) != payloadSize || fflush(file) != 0) {
+        // Part of the frame may be on disk; rewind to the end of the last good frame so the
+        // next one overwrites it and index offsets stay right
+        framesDropped++;
+        clearerr(file);
+        if (fseek(file, (long)writeOffset, SEEK_SET) != 0) {
+            // Offsets can no longer be trusted: keep what is on disk and let readers scan it
+            LOGE("Cannot recover from failed write, dropping the rest of the recording");
+            fileBroken = true;
+            indexValid = false;
+        }
+        return false;
+    }
+
+    RecordingIndexEntry entry;
+    entry.offset = writeOffset;
+    entry.timestampNs = header.timestampNs;
+    if (indexValid && fwrite(&entry, sizeof(entry), 1, indexFile) != 1) {
+        // Readers rebuild a missing index from the frame headers
+        LOGE("Failed to write index entry, recording will be closed without an index");
+        indexValid = false;
+    }
+    writeOffset += sizeof(header) + payloadSize;
+    framesWritten++;
+    return true;
+}
+
+void FrameRecorder::finishFile() {
+    if (file == nullptr) {
+        return;
+    }
+
+    // Append the frame index from the sidecar, a block at a time, right after the last good frame
+    uint32_t frameCount = framesWritten.load();
+    bool indexOk = indexValid && fflush(indexFile) == 0 && fseek(indexFile, 0, SEEK_SET) == 0 &&
+                   fseek(file, (long)writeOffset, SEEK_SET) == 0;
+    RecordingIndexEntry block[256];
+    uint32_t copied = 0;
+    while (indexOk && copied < frameCount) {
+        size_t count = std::min<size_t>(frameCount - copied, sizeof(block) / sizeof(block[0]));
+        indexOk = fread(block, sizeof(RecordingIndexEntry), count, indexFile) == count &&
+                  fwrite(block, sizeof(RecordingIndexEntry), count, file) == count;
+        copied += (uint32_t)count;
+    }
+    fclose(indexFile);
+    indexFile = nullptr;
+    remove(indexPath.c_str());
+
+    // Point the file header at the index; without one readers fall back to scanning frames
+    RecordingFileHeader header = {};
+    memcpy(header.magic, kRecordingFileMagic, sizeof(header.magic));
+    header.version = kRecordingVersion;
+    header.width = (uint32_t)frameWidth;
+    header.height = (uint32_t)frameHeight;
+    header.frameCount = indexOk ? frameCount : 0;
+    header.indexOffset = indexOk ? writeOffset : 0;
+
+    if (!indexOk) {
+        LOGE("Failed to write recording index");
+    }
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1) {
+        LOGE("Failed to write recording header");
+    }
+
+    fclose(file);
+    file = nullptr;
+}
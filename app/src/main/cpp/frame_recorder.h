@@ -0,0 +1,82 @@
+#ifndef EDGEDETECTION_FRAME_RECORDER_H
+#define EDGEDETECTION_FRAME_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "edge_recording.h"
+
+// Records processed frames to an .edgr file (see edge_recording.h) without blocking
+// the caller. Frames are copied into a fixed pool of preallocated slots and a
+// background thread encodes and writes them. When every slot is busy the frame is
+// dropped, so memory use is capped at queueDepth frames regardless of disk speed.
+// Seek index entries go to a "<path>.idx" sidecar as frames are written and are only
+// copied into the recording when it is closed, so long recordings do not grow memory either.
+class FrameRecorder {
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    // `stride` is the row pitch kept in the file; raw luma captures keep the camera's row stride
+    bool start(const std::string& path, int width, int height, int stride, int queueDepth, RecordingEncoding encoding);
+    void stop();
+    bool isRecording() const { return running.load(std::memory_order_acquire); }
+
+    // Called from the camera thread. Never waits on I/O; returns false if the frame was dropped.
+    bool submitFrame(const uint8_t* data, int width, int height, int stride, int64_t timestampNs);
+
+    uint32_t getFramesWritten() const { return framesWritten.load(); }
+    uint32_t getFramesDropped() const { return framesDropped.load(); }
+
+private:
+    struct Slot {
+        std::vector<uint8_t> pixels;
+        int64_t timestampNs;
+    };
+
+    FILE* file;
+    FILE* indexFile;
+    std::string indexPath;
+    bool indexValid;
+    // Set by the writer when a failed write could not be rewound
+    bool fileBroken;
+    int frameWidth;
+    int frameHeight;
+    int frameStride;
+    RecordingEncoding frameEncoding;
+
+    // Serializes start() and stop(), which may be called from different threads
+    std::mutex lifecycleMutex;
+
+    // Slot pool, guarded by queueMutex. freeSlots is used as a stack and readySlots as a
+    // ring buffer; both are sized once in start() so submitting never allocates.
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::vector<Slot> slots;
+    std::vector<int> freeSlots;
+    std::vector<int> readySlots;
+    size_t readyHead;
+    size_t readyCount;
+    int submitsInFlight;
+    bool stopRequested;
+
+    std::atomic<bool> running;
+    std::atomic<uint32_t> framesWritten;
+    std::atomic<uint32_t> framesDropped;
+
+    // Owned by the writer thread
+    std::thread writerThread;
+    std::vector<uint8_t> encodeBuffer;
+    uint64_t writeOffset;
+
+    void writerLoop();
+    bool writeFrame(Slot& slot, int slotIndex);
+    void finishFile();
+};
+
+#endif // EDGEDETECTION_FRAME_RECORDER_H
@@ -3,133 +3,58 @@
 #include <android/log.h>
 #include <cstring>
 #include <cmath>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
 #include "opencv_processor.h"
 #include "gl_renderer.h"
+#include "frame_recorder.h"
+#include "edge_detector.h"
+#include "worker_pool.h"
 
 #define LOG_TAG "NativeLib"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// Sobel edge detection kernels
-const int sobelX[3][3] = {
-    {-1, 0, 1},
-    {-2, 0, 2},
-    {-1, 0, 1}
-};
+OpenCVProcessor* processor = nullptr;
+EdgeDetector* edgeDetector = nullptr;
+WorkerPool* workerPool = nullptr;
+GLRenderer* renderer = nullptr;
+// Recorders are created on first use and never deleted: the analyzer thread may still be
+// inside submitFrame when recording stops or the processor is released
+std::atomic<FrameRecorder*> recorder(nullptr);
+std::atomic<FrameRecorder*> capturer(nullptr);
 
-const int sobelY[3][3] = {
-    {-1, -2, -1},
-    { 0,  0,  0},
-    { 1,  2,  1}
-};
+// startCapture only arms the capture: the camera's row stride is known once the first
+// frame arrives, so captureFrame starts the recorder with that frame's geometry
+std::mutex captureMutex;
+std::string pendingCapturePath;
+int pendingCaptureQueueDepth = 0;
 
-// Gaussian blur kernel for noise reduction
-const float gaussianKernel[5][5] = {
-    {1, 4, 6, 4, 1},
-    {4, 16, 24, 16, 4},
-    {6, 24, 36, 24, 6},
-    {4, 16, 24, 16, 4},
-    {1, 4, 6, 4, 1}
+// Reported to Kotlin by getCaptureState; keep in sync with NativeLib.kt
+enum CaptureState {
+    kCaptureIdle = 0,
+    kCaptureArmed = 1,   // waiting for the first frame
+    kCaptureRunning = 2,
+    kCaptureFailed = 3,  // the recorder could not be started with the first frame
 };
+std::atomic<int> captureState(kCaptureIdle);
 
-// Apply Gaussian blur to reduce noise
-void applyGaussianBlur(unsigned char* input, unsigned char* output, int width, int height) {
-    const float kernelSum = 256.0f; // Sum of all kernel values
-    
-    for (int y = 2; y < height - 2; y++) {
-        for (int x = 2; x < width - 2; x++) {
-            float sum = 0;
-            
-            for (int ky = -2; ky <= 2; ky++) {
-                for (int kx = -2; kx <= 2; kx++) {
-                    int pixelIdx = (y + ky) * width + (x + kx);
-                    sum += input[pixelIdx] * gaussianKernel[ky + 2][kx + 2];
-                }
-            }
-            
-            output[y * width + x] = (unsigned char)(sum / kernelSum);
-        }
-    }
-}
-
-// Apply advanced Sobel edge detection with non-maximum suppression
-void applySobelEdgeDetection(unsigned char* input, unsigned char* output, int width, int height) {
-    unsigned char* gradientMag = new unsigned char[width * height];
-    float* gradientDir = new float[width * height];
-    
-    // Step 1: Calculate gradients
-    for (int y = 1; y < height - 1; y++) {
-        for (int x = 1; x < width - 1; x++) {
-            int gradientX = 0;
-            int gradientY = 0;
-            
-            // Apply Sobel kernels
-            for (int ky = -1; ky <= 1; ky++) {
-                for (int kx = -1; kx <= 1; kx++) {
-                    int pixelIdx = (y + ky) * width + (x + kx);
-                    unsigned char pixelValue = input[pixelIdx];
-                    
-                    gradientX += pixelValue * sobelX[ky + 1][kx + 1];
-                    gradientY += pixelValue * sobelY[ky + 1][kx + 1];
-                }
-            }
-            
-            // Calculate magnitude and direction
-            float magnitude = sqrt(gradientX * gradientX + gradientY * gradientY);
-            float direction = atan2(gradientY, gradientX);
-            
-            int idx = y * width + x;
-            gradientMag[idx] = (magnitude > 255) ? 255 : (unsigned char)magnitude;
-            gradientDir[idx] = direction;
-        }
+FrameRecorder* getOrCreateRecorder(std::atomic<FrameRecorder*>& instance) {
+    FrameRecorder* existing = instance.load(std::memory_order_acquire);
+    if (existing != nullptr) {
+        return existing;
     }
-    
-    // Step 2: Non-maximum suppression for thinner edges
-    for (int y = 1; y < height - 1; y++) {
-        for (int x = 1; x < width - 1; x++) {
-            int idx = y * width + x;
-            float angle = gradientDir[idx];
-            unsigned char mag = gradientMag[idx];
-            
-            // Determine neighbors based on gradient direction
-            unsigned char neighbor1, neighbor2;
-            
-            if ((angle >= -22.5 && angle <= 22.5) || (angle >= 157.5 || angle <= -157.5)) {
-                // Horizontal edge
-                neighbor1 = gradientMag[y * width + (x + 1)];
-                neighbor2 = gradientMag[y * width + (x - 1)];
-            } else if ((angle >= 22.5 && angle <= 67.5) || (angle >= -157.5 && angle <= -112.5)) {
-                // Diagonal edge (/)
-                neighbor1 = gradientMag[(y + 1) * width + (x - 1)];
-                neighbor2 = gradientMag[(y - 1) * width + (x + 1)];
-            } else if ((angle >= 67.5 && angle <= 112.5) || (angle >= -112.5 && angle <= -67.5)) {
-                // Vertical edge
-                neighbor1 = gradientMag[(y + 1) * width + x];
-                neighbor2 = gradientMag[(y - 1) * width + x];
-            } else {
-                // Diagonal edge (\)
-                neighbor1 = gradientMag[(y + 1) * width + (x + 1)];
-                neighbor2 = gradientMag[(y - 1) * width + (x - 1)];
-            }
-            
-            // Suppress non-maximum pixels
-            if (mag >= neighbor1 && mag >= neighbor2 && mag > 30) {
-                // Apply enhanced contrast for strong edges
-                int enhanced = (int)(mag * 1.5);
-                output[idx] = (enhanced > 255) ? 255 : (unsigned char)enhanced;
-            } else {
-                output[idx] = 0;
-            }
-        }
+    FrameRecorder* created = new FrameRecorder();
+    if (!instance.compare_exchange_strong(existing, created, std::memory_order_acq_rel)) {
+        // Another thread got there first
+        delete created;
+        return existing;
     }
-    
-    delete[] gradientMag;
-    delete[] gradientDir;
+    return created;
 }
 
-OpenCVProcessor* processor = nullptr;
-GLRenderer* renderer = nullptr;
-
 extern "C" JNIEXPORT jstring JNICALL
 Java_com_example_edgedetectionapp_NativeLib_stringFromJNI(
         JNIEnv* env,
@@ -147,6 +72,9 @@ Java_com_example_edgedetectionapp_NativeLib_initProcessor(
     try {
         if (processor == nullptr) {
             processor = new OpenCVProcessor();
+            edgeDetector = new EdgeDetector();
+            workerPool = new WorkerPool();
+            edgeDetector->setWorkerPool(workerPool);
             LOGD("OpenCV Processor created successfully");
         } else {
             LOGD("OpenCV Processor already initialized");
@@ -203,31 +131,29 @@ Java_com_example_edgedetectionapp_NativeLib_processFrameData(
     jbyte* outputData = env->GetByteArrayElements(result, nullptr);
     
     if (applyEdgeDetection) {
-        // Convert input to unsigned char
-        unsigned char* inputBuffer = new unsigned char[width * height];
-        unsigned char* tempBuffer = new unsigned char[width * height];
-        unsigned char* outputBuffer = new unsigned char[width * height];
-        
-        // Extract luminance from YUV format (first plane)
-        for (int i = 0; i < width * height && i < dataSize; i++) {
-            inputBuffer[i] = (unsigned char)(inputData[i] & 0xFF);
+        // Read the luminance (first) plane in place; the detector keeps its own padded copy
+        const unsigned char* luma = (const unsigned char*)inputData;
+        std::vector<unsigned char> shortFrame;
+        if (dataSize < width * height) {
+            shortFrame.assign(width * height, 0);
+            memcpy(shortFrame.data(), inputData, dataSize);
+            luma = shortFrame.data();
         }
         
-        // Step 1: Apply Gaussian blur to reduce noise
-        applyGaussianBlur(inputBuffer, tempBuffer, width, height);
-        
-        // Step 2: Apply advanced Sobel edge detection
-        applySobelEdgeDetection(tempBuffer, outputBuffer, width, height);
+        // Gaussian blur, Sobel and non-maximum suppression straight into the output array
+        unsigned char* outputBuffer = (unsigned char*)outputData;
+        edgeDetector->process(luma, width, outputBuffer, width, width, height);
+        EdgeThresholds thresholds = edgeDetector->getLastThresholds();
+        LOGD("Edge thresholds: low %d, high %d", thresholds.low, thresholds.high);
         
-        // Copy processed data back to output
-        for (int i = 0; i < width * height; i++) {
-            outputData[i] = (jbyte)outputBuffer[i];
+        // Hand the edge map to the recorder; this only copies into a free slot or drops the frame
+        FrameRecorder* frameRecorder = recorder.load(std::memory_order_acquire);
+        if (frameRecorder != nullptr && frameRecorder->isRecording()) {
+            int64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            frameRecorder->submitFrame(outputBuffer, width, height, width, timestampNs);
         }
         
-        delete[] inputBuffer;
-        delete[] tempBuffer;
-        delete[] outputBuffer;
-        
         LOGD("Applied advanced Sobel edge detection with noise reduction");
     } else {
         // Pass through unchanged
@@ -252,6 +178,198 @@ Java_com_example_edgedetectionapp_NativeLib_releaseProcessor(
         delete processor;
         processor = nullptr;
     }
+    if (edgeDetector != nullptr) {
+        delete edgeDetector;
+        edgeDetector = nullptr;
+    }
+    if (workerPool != nullptr) {
+        delete workerPool;
+        workerPool = nullptr;
+    }
+    // Finish any open files but keep the recorders alive (see getOrCreateRecorder)
+    if (FrameRecorder* frameRecorder = recorder.load(std::memory_order_acquire)) {
+        frameRecorder->stop();
+    }
+    {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        pendingCapturePath.clear();
+        captureState = kCaptureIdle;
+    }
+    if (FrameRecorder* frameCapturer = capturer.load(std::memory_order_acquire)) {
+        frameCapturer->stop();
+    }
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_edgedetectionapp_NativeLib_setMultiScale(
+        JNIEnv* env,
+        jobject /* this */,
+        jint levels,
+        jint mergeMode) {
+    LOGD("Multi-scale edge detection: %d level(s), merge mode %d", levels, mergeMode);
+    if (edgeDetector == nullptr) {
+        LOGE("Processor not initialized");
+        return;
+    }
+    edgeDetector->setScaleLevels(levels, mergeMode == kMergeVote ? kMergeVote : kMergeMax);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_edgedetectionapp_NativeLib_setAutoThreshold(
+        JNIEnv* env,
+        jobject /* this */,
+        jint mode,
+        jfloat percentile) {
+    LOGD("Edge threshold mode %d, percentile %.1f", mode, percentile);
+    if (edgeDetector == nullptr) {
+        LOGE("Processor not initialized");
+        return;
+    }
+    ThresholdMode thresholdMode = kThresholdFixed;
+    if (mode == kThresholdOtsu || mode == kThresholdPercentile) {
+        thresholdMode = (ThresholdMode)mode;
+    }
+    edgeDetector->setThresholdMode(thresholdMode, percentile);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionapp_NativeLib_startRecording(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring path,
+        jint width,
+        jint height,
+        jint queueDepth) {
+    
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        LOGE("Failed to get recording path");
+        return JNI_FALSE;
+    }
+    std::string recordingPath(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    
+    LOGD("Starting recording: %s (%dx%d, queue depth %d)", recordingPath.c_str(), width, height, queueDepth);
+    return getOrCreateRecorder(recorder)->start(recordingPath, width, height, width, queueDepth, kEncodingEdgeRle) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_edgedetectionapp_NativeLib_stopRecording(
+        JNIEnv* env,
+        jobject /* this */) {
+    LOGD("Stopping recording");
+    FrameRecorder* frameRecorder = recorder.load(std::memory_order_acquire);
+    if (frameRecorder == nullptr) {
+        return 0;
+    }
+    frameRecorder->stop();
+    return (jint)frameRecorder->getFramesWritten();
+}
+
+// Raw camera luma capture for offline replay (see tools/edge_replay.cpp)
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionapp_NativeLib_startCapture(
+        JNIEnv* env,
+        jobject /* this */,
+        jstring path,
+        jint queueDepth) {
+    
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (pathChars == nullptr) {
+        LOGE("Failed to get capture path");
+        return JNI_FALSE;
+    }
+    std::string capturePath(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    
+    LOGD("Arming capture: %s (queue depth %d)", capturePath.c_str(), queueDepth);
+    FrameRecorder* frameCapturer = getOrCreateRecorder(capturer);
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (frameCapturer->isRecording() || queueDepth <= 0) {
+        LOGE("Capture already running or invalid queue depth");
+        return JNI_FALSE;
+    }
+    pendingCapturePath = capturePath;
+    pendingCaptureQueueDepth = queueDepth;
+    captureState = kCaptureArmed;
+    return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_example_edgedetectionapp_NativeLib_captureFrame(
+        JNIEnv* env,
+        jobject /* this */,
+        jobject lumaBuffer,
+        jint width,
+        jint height,
+        jint rowStride,
+        jlong timestampNs) {
+    
+    FrameRecorder* frameCapturer = capturer.load(std::memory_order_acquire);
+    if (frameCapturer == nullptr) {
+        return JNI_FALSE;
+    }
+    
+    // Read the camera plane in place; the recorder copies it into a free slot
+    const uint8_t* luma = (const uint8_t*)env->GetDirectBufferAddress(lumaBuffer);
+    jlong capacity = env->GetDirectBufferCapacity(lumaBuffer);
+    if (luma == nullptr || height <= 0 || capacity < (jlong)rowStride * (height - 1) + width) {
+        LOGE("Invalid luma buffer for capture");
+        return JNI_FALSE;
+    }
+    
+    if (!frameCapturer->isRecording()) {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        if (pendingCapturePath.empty()) {
+            return JNI_FALSE;
+        }
+        // First frame of an armed capture; later frames must keep this geometry
+        LOGD("Starting capture: %s (%dx%d, stride %d)", pendingCapturePath.c_str(), width, height, rowStride);
+        bool started = frameCapturer->start(pendingCapturePath, width, height, rowStride,
+                                            pendingCaptureQueueDepth, kEncodingRaw);
+        pendingCapturePath.clear();
+        captureState = started ? kCaptureRunning : kCaptureFailed;
+        if (!started) {
+            return JNI_FALSE;
+        }
+    }
+    
+    return frameCapturer->submitFrame(luma, width, height, rowStride, timestampNs) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_edgedetectionapp_NativeLib_stopCapture(
+        JNIEnv* env,
+        jobject /* this */) {
+    LOGD("Stopping capture");
+    {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        pendingCapturePath.clear();
+        captureState = kCaptureIdle;
+    }
+    FrameRecorder* frameCapturer = capturer.load(std::memory_order_acquire);
+    if (frameCapturer == nullptr) {
+        return 0;
+    }
+    frameCapturer->stop();
+    return (jint)frameCapturer->getFramesWritten();
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_edgedetectionapp_NativeLib_getCaptureState(
+        JNIEnv* env,
+        jobject /* this */) {
+    return (jint)captureState.load();
+}
+
+// Frames of the current or last capture that were not written: the writer fell behind,
+// or the camera changed resolution or row stride after the first frame
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_edgedetectionapp_NativeLib_getCaptureDroppedFrames(
+        JNIEnv* env,
+        jobject /* this */) {
+    FrameRecorder* frameCapturer = capturer.load(std::memory_order_acquire);
+    return frameCapturer != nullptr ? (jint)frameCapturer->getFramesDropped() : 0;
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -0,0 +1,53 @@
+#include "padded_image.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+ptrdiff_t alignUp(ptrdiff_t value) {
+    return (value + kPaddedRowAlignment - 1) / kPaddedRowAlignment * kPaddedRowAlignment;
+}
+
+} // namespace
+
+PaddedImage::PaddedImage() : width(0), height(0), border(0), pitch(0), origin(nullptr) {
+}
+
+void PaddedImage::reset(int width, int height, int border) {
+    this->width = width;
+    this->height = height;
+    this->border = border;
+
+    // Round the left border up so that pixel (0, y) starts on an aligned address
+    ptrdiff_t leftPad = alignUp(border);
+    pitch = alignUp(leftPad + width + border);
+    size_t required = (size_t)pitch * (height + 2 * border) + kPaddedRowAlignment;
+    if (storage.size() < required) {
+        storage.resize(required);
+    }
+
+    uintptr_t base = (uintptr_t)storage.data();
+    uintptr_t alignedBase = (base + kPaddedRowAlignment - 1) / kPaddedRowAlignment * kPaddedRowAlignment;
+    origin = (unsigned char*)alignedBase + (ptrdiff_t)border * pitch + leftPad;
+}
+
+void PaddedImage::copyFrom(const unsigned char* src, ptrdiff_t srcStride) {
+    for (int y = 0; y < height; y++) {
+        memcpy(row(y), src + y * srcStride, width);
+    }
+}
+
+void PaddedImage::replicateBorders() {
+    // Left and right columns first, so the row copies below also fill the corners
+    for (int y = 0; y < height; y++) {
+        unsigned char* line = row(y);
+        for (int i = 1; i <= border; i++) {
+            line[-i] = line[0];
+            line[width - 1 + i] = line[width - 1];
+        }
+    }
+    for (int i = 1; i <= border; i++) {
+        memcpy(row(-i) - border, row(0) - border, width + 2 * border);
+        memcpy(row(height - 1 + i) - border, row(height - 1) - border, width + 2 * border);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef EDGEDETECTION_PADDED_IMAGE_H
+#define EDGEDETECTION_PADDED_IMAGE_H
+
+#include <cstddef>
+#include <vector>
+
+// Row starts are aligned to this many bytes so kernels can use aligned vector loads
+const int kPaddedRowAlignment = 64;
+
+// 8-bit single channel image surrounded by `border` pixels on every side.
+// Once the border is filled (replicated from the edge pixels) a kernel
+// with radius <= border can read its whole neighbourhood for every pixel of the image,
+// so inner loops need no bounds checks and every output pixel gets written.
+class PaddedImage {
+public:
+    PaddedImage();
+
+    // Resizes the image; storage is only reallocated when it has to grow
+    void reset(int width, int height, int border);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getBorder() const { return border; }
+    ptrdiff_t getPitch() const { return pitch; }
+
+    // Pointer to pixel (0, y); valid for x in [-border, width + border) and
+    // y in [-border, height + border)
+    unsigned char* row(int y) { return origin + (ptrdiff_t)y * pitch; }
+    const unsigned char* row(int y) const { return origin + (ptrdiff_t)y * pitch; }
+
+    // Copies a tightly packed or strided plane into the interior
+    void copyFrom(const unsigned char* src, ptrdiff_t srcStride);
+
+    // Fill the border from the image edge: aaa|abcd|ddd
+    void replicateBorders();
+
+private:
+    int width;
+    int height;
+    int border;
+    ptrdiff_t pitch;
+    std::vector<unsigned char> storage;
+    unsigned char* origin;
+};
+
+#endif // EDGEDETECTION_PADDED_IMAGE_H
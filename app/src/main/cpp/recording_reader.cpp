@@ -0,0 +1,120 @@
+#include "recording_reader.h"
+#include <cstring>
+
+RecordingReader::RecordingReader() : file(nullptr), header() {
+}
+
+RecordingReader::~RecordingReader() {
+    close();
+}
+
+bool RecordingReader::open(const std::string& path) {
+    close();
+
+    file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return fail("cannot open " + path);
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, kRecordingFileMagic, sizeof(header.magic)) != 0) {
+        return fail("not an edge recording: " + path);
+    }
+    if (header.version != kRecordingVersion) {
+        return fail("unsupported recording version " + std::to_string(header.version));
+    }
+
+    // An unfinished recording has no index; rebuild it from the frame headers
+    return header.indexOffset != 0 ? readIndex() : scanFrames();
+}
+
+void RecordingReader::close() {
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+    index.clear();
+}
+
+bool RecordingReader::readFrame(size_t frame, Frame& out) {
+    if (file == nullptr || frame >= index.size()) {
+        return fail("frame " + std::to_string(frame) + " out of range");
+    }
+
+    RecordingFrameHeader frameHeader;
+    if (fseek(file, (long)index[frame].offset, SEEK_SET) != 0 ||
+        fread(&frameHeader, sizeof(frameHeader), 1, file) != 1 ||
+        memcmp(frameHeader.magic, kRecordingFrameMagic, sizeof(frameHeader.magic)) != 0) {
+        return fail("corrupt frame header at frame " + std::to_string(frame));
+    }
+    if (frameHeader.stride < frameHeader.width) {
+        return fail("invalid stride at frame " + std::to_string(frame));
+    }
+
+    payload.resize(frameHeader.payloadSize);
+    if (frameHeader.payloadSize > 0 &&
+        fread(payload.data(), 1, payload.size(), file) != payload.size()) {
+        return fail("truncated payload at frame " + std::to_string(frame));
+    }
+
+    out.width = (int)frameHeader.width;
+    out.height = (int)frameHeader.height;
+    out.stride = (int)frameHeader.stride;
+    out.timestampNs = frameHeader.timestampNs;
+    size_t planeSize = (size_t)frameHeader.stride * frameHeader.height;
+    out.pixels.resize(planeSize);
+
+    switch (frameHeader.encoding) {
+        case kEncodingRaw:
+            if (payload.size() != planeSize) {
+                return fail("raw payload size mismatch at frame " + std::to_string(frame));
+            }
+            memcpy(out.pixels.data(), payload.data(), planeSize);
+            return true;
+        case kEncodingEdgeRle:
+            if (!decodeEdgeRle(payload.data(), payload.size(), out.pixels.data(), planeSize)) {
+                return fail("corrupt RLE payload at frame " + std::to_string(frame));
+            }
+            return true;
+        default:
+            return fail("unknown encoding " + std::to_string(frameHeader.encoding));
+    }
+}
+
+bool RecordingReader::readIndex() {
+    index.resize(header.frameCount);
+    if (fseek(file, (long)header.indexOffset, SEEK_SET) != 0 ||
+        (header.frameCount > 0 &&
+         fread(index.data(), sizeof(RecordingIndexEntry), index.size(), file) != index.size())) {
+        return fail("truncated frame index");
+    }
+    return true;
+}
+
+bool RecordingReader::scanFrames() {
+    if (fseek(file, 0, SEEK_END) != 0) {
+        return fail("cannot seek recording");
+    }
+    long fileSize = ftell(file);
+    long offset = (long)sizeof(header);
+    RecordingFrameHeader frameHeader;
+    while (fseek(file, offset, SEEK_SET) == 0 &&
+           fread(&frameHeader, sizeof(frameHeader), 1, file) == 1 &&
+           memcmp(frameHeader.magic, kRecordingFrameMagic, sizeof(frameHeader.magic)) == 0) {
+        long next = offset + (long)sizeof(frameHeader) + (long)frameHeader.payloadSize;
+        // Stop at a frame whose payload was cut off by the crash
+        if (next > fileSize) {
+            break;
+        }
+        RecordingIndexEntry entry;
+        entry.offset = (uint64_t)offset;
+        entry.timestampNs = frameHeader.timestampNs;
+        index.push_back(entry);
+        offset = next;
+    }
+    return true;
+}
+
+bool RecordingReader::fail(const std::string& message) {
+    lastError = message;
+    return false;
+}
@@ -0,0 +1,49 @@
+#ifndef EDGEDETECTION_RECORDING_READER_H
+#define EDGEDETECTION_RECORDING_READER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "edge_recording.h"
+
+// Reads .edgr files written by FrameRecorder. Uses the trailing index when the
+// recording was closed cleanly and falls back to walking frame headers otherwise.
+class RecordingReader {
+public:
+    struct Frame {
+        int width;
+        int height;
+        int stride;
+        int64_t timestampNs;
+        // Decoded plane, `stride` bytes per row
+        std::vector<uint8_t> pixels;
+    };
+
+    RecordingReader();
+    ~RecordingReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    int getWidth() const { return (int)header.width; }
+    int getHeight() const { return (int)header.height; }
+    size_t getFrameCount() const { return index.size(); }
+    int64_t getFrameTimestamp(size_t frame) const { return index[frame].timestampNs; }
+
+    bool readFrame(size_t frame, Frame& out);
+    const std::string& getLastError() const { return lastError; }
+
+private:
+    FILE* file;
+    RecordingFileHeader header;
+    std::vector<RecordingIndexEntry> index;
+    std::vector<uint8_t> payload;
+    std::string lastError;
+
+    bool readIndex();
+    bool scanFrames();
+    bool fail(const std::string& message);
+};
+
+#endif // EDGEDETECTION_RECORDING_READER_H
@@ -0,0 +1,196 @@
+#include "strip_processor.h"
+#include "edge_detector.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Read-only or read-write view of a whole file
+struct MappedFile {
+    int fd = -1;
+    unsigned char* data = nullptr;
+    size_t size = 0;
+
+    ~MappedFile() {
+        if (data != nullptr) munmap(data, size);
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+bool mapInput(const std::string& path, MappedFile& file, std::string& error) {
+    file.fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (file.fd < 0 || fstat(file.fd, &info) != 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    file.size = (size_t)info.st_size;
+    if (file.size == 0) {
+        error = "empty input file " + path;
+        return false;
+    }
+    void* data = mmap(nullptr, file.size, PROT_READ, MAP_SHARED, file.fd, 0);
+    if (data == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    file.data = (unsigned char*)data;
+    madvise(file.data, file.size, MADV_SEQUENTIAL);
+    return true;
+}
+
+bool mapOutput(const std::string& path, size_t size, MappedFile& file, std::string& error) {
+    file.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file.fd < 0 || ftruncate(file.fd, (off_t)size) != 0) {
+        error = "cannot create " + path;
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+    if (data == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    file.data = (unsigned char*)data;
+    file.size = size;
+    return true;
+}
+
+// Parses a binary PGM header. On success `dataOffset` points at the first pixel.
+bool parsePgmHeader(const unsigned char* data, size_t size, int& width, int& height, int& maxValue,
+                    size_t& dataOffset) {
+    if (size < 2 || data[0] != 'P' || data[1] != '5') {
+        return false;
+    }
+    size_t pos = 2;
+    long values[3];
+    for (int field = 0; field < 3; field++) {
+        // Skip whitespace and comment lines
+        while (pos < size && (isspace(data[pos]) || data[pos] == '#')) {
+            if (data[pos] == '#') {
+                while (pos < size && data[pos] != '\n') pos++;
+            } else {
+                pos++;
+            }
+        }
+        if (pos >= size || !isdigit(data[pos])) {
+            return false;
+        }
+        long value = 0;
+        while (pos < size && isdigit(data[pos]) && value < 1000000000L) {
+            value = value * 10 + (data[pos++] - '0');
+        }
+        values[field] = value;
+    }
+    // Exactly one whitespace byte separates the header from the raster
+    if (pos >= size || !isspace(data[pos]) || values[2] <= 0 || values[2] > 65535) {
+        return false;
+    }
+    width = (int)values[0];
+    height = (int)values[1];
+    maxValue = (int)values[2];
+    dataOffset = pos + 1;
+    return width > 0 && height > 0;
+}
+
+// Drops already-processed pages from this process; the page cache keeps the data
+void releasePages(unsigned char* base, size_t begin, size_t end) {
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t alignedBegin = (begin + pageSize - 1) / pageSize * pageSize;
+    size_t alignedEnd = end / pageSize * pageSize;
+    if (alignedEnd > alignedBegin) {
+        madvise(base + alignedBegin, alignedEnd - alignedBegin, MADV_DONTNEED);
+    }
+}
+
+} // namespace
+
+bool processImageFileInStrips(const std::string& inputPath, const std::string& outputPath,
+                              const StripOptions& options, WorkerPool& pool, std::string& error) {
+    MappedFile input;
+    if (!mapInput(inputPath, input, error)) {
+        return false;
+    }
+
+    int width = options.width;
+    int height = options.height;
+    size_t inputOffset = 0;
+    int maxValue = 255;
+    bool isPgm = parsePgmHeader(input.data, input.size, width, height, maxValue, inputOffset);
+    if (!isPgm && input.size >= 2 && input.data[0] == 'P' && input.data[1] == '5') {
+        error = "malformed PGM header";
+        return false;
+    }
+    if (isPgm && maxValue != 255) {
+        // The kernels and thresholds assume samples span 0-255
+        error = "only 8-bit PGM with maxval 255 is supported (got maxval " + std::to_string(maxValue) + ")";
+        return false;
+    }
+    if (!isPgm && (width <= 0 || height <= 0)) {
+        error = "raw input needs --width and --height";
+        return false;
+    }
+    size_t imageSize = (size_t)width * height;
+    if (input.size - inputOffset < imageSize) {
+        error = "input is smaller than " + std::to_string(width) + "x" + std::to_string(height);
+        return false;
+    }
+
+    // Same container as the input: PGM in, PGM out
+    char header[64] = "";
+    if (isPgm) {
+        snprintf(header, sizeof(header), "P5\n%d %d\n255\n", width, height);
+    }
+    size_t outputOffset = strlen(header);
+    MappedFile output;
+    if (!mapOutput(outputPath, outputOffset + imageSize, output, error)) {
+        return false;
+    }
+    memcpy(output.data, header, outputOffset);
+
+    // Aim for a few MB of source rows per strip so per-thread scratch stays small
+    int stripRows = options.stripRows > 0 ? options.stripRows
+                                          : std::max(64, std::min(1024, (4 << 20) / width));
+    stripRows = std::min(stripRows, height);
+    int stripCount = (height + stripRows - 1) / stripRows;
+
+    const unsigned char* pixels = input.data + inputOffset;
+    unsigned char* outPixels = output.data + outputOffset;
+    // Per-worker detector (reused intermediates) and strip output
+    std::vector<EdgeDetector> detectors(pool.getThreadCount());
+    std::vector<std::vector<unsigned char>> scratch(pool.getThreadCount());
+
+    pool.parallelFor(stripCount, [&](int strip, int worker) {
+        int y0 = strip * stripRows;
+        int y1 = std::min(height, y0 + stripRows);
+
+        // Add halo rows so the strip's own rows see the same neighbourhood as a full-frame pass
+        int haloTop = std::max(0, y0 - kEdgePipelineHalo);
+        int haloBottom = std::min(height, y1 + kEdgePipelineHalo);
+        int windowRows = haloBottom - haloTop;
+
+        std::vector<unsigned char>& stripOutput = scratch[worker];
+        stripOutput.resize((size_t)windowRows * width);
+        detectors[worker].process(pixels + (size_t)haloTop * width, width, stripOutput.data(), width, width, windowRows);
+
+        memcpy(outPixels + (size_t)y0 * width,
+               stripOutput.data() + (size_t)(y0 - haloTop) * width,
+               (size_t)(y1 - y0) * width);
+
+        releasePages(output.data, outputOffset + (size_t)y0 * width, outputOffset + (size_t)y1 * width);
+        releasePages(input.data, inputOffset + (size_t)haloTop * width, inputOffset + (size_t)haloBottom * width);
+    });
+
+    if (msync(output.data, output.size, MS_SYNC) != 0) {
+        error = "failed to flush " + outputPath;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,25 @@
+#ifndef EDGEDETECTION_STRIP_PROCESSOR_H
+#define EDGEDETECTION_STRIP_PROCESSOR_H
+
+#include <string>
+
+class WorkerPool;
+
+// Out-of-core edge detection for images too large to hold in memory with the
+// pipeline's temporaries. Input and output files are memory-mapped and the image is
+// processed as horizontal strips (plus halo rows) on the worker pool, so peak memory
+// is proportional to width * stripRows * threads rather than to image height.
+struct StripOptions {
+    // Raw Y8 input needs explicit dimensions; PGM (P5) input carries its own
+    int width = 0;
+    int height = 0;
+    // Output rows per strip; 0 picks a size from the image width
+    int stripRows = 0;
+};
+
+// Reads an 8-bit PGM (P5) or raw Y8 file and writes the edge map to `outputPath`
+// in the same format. Returns false and fills `error` on failure.
+bool processImageFileInStrips(const std::string& inputPath, const std::string& outputPath,
+                              const StripOptions& options, WorkerPool& pool, std::string& error);
+
+#endif // EDGEDETECTION_STRIP_PROCESSOR_H
@@ -0,0 +1,129 @@
+// Multi-scale detection: edges stay as thin as single-scale ones and where level 0 puts
+// them, pooled runs match single-threaded ones, and settings may change mid-stream.
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "../edge_detector.h"
+#include "../worker_pool.h"
+#include "test_util.h"
+
+namespace {
+
+const int kWidth = 256;
+const int kHeight = 64;
+
+// Vertical step between x = 100 and x = 101
+std::vector<unsigned char> makeStep() {
+    std::vector<unsigned char> image((size_t)kWidth * kHeight);
+    for (int y = 0; y < kHeight; y++) {
+        for (int x = 0; x < kWidth; x++) {
+            image[(size_t)y * kWidth + x] = x <= 100 ? 60 : 190;
+        }
+    }
+    return image;
+}
+
+std::vector<unsigned char> makeNoise() {
+    std::vector<unsigned char> image((size_t)kWidth * kHeight);
+    srand(11);
+    for (size_t i = 0; i < image.size(); i++) {
+        int x = (int)(i % kWidth);
+        image[i] = (unsigned char)(((x / 19) % 2 ? 180 : 70) + rand() % 81 - 40);
+    }
+    return image;
+}
+
+std::vector<unsigned char> run(EdgeDetector& detector, const std::vector<unsigned char>& image) {
+    std::vector<unsigned char> output(image.size());
+    detector.process(image.data(), kWidth, output.data(), kWidth, kWidth, kHeight);
+    return output;
+}
+
+void testStepStaysThin() {
+    std::vector<unsigned char> image = makeStep();
+    const ScaleMergeMode modes[] = {kMergeMax, kMergeVote};
+    for (ScaleMergeMode mode : modes) {
+        for (int levels = 1; levels <= kMaxScaleLevels; levels++) {
+            EdgeDetector detector;
+            detector.setScaleLevels(levels, mode);
+            std::vector<unsigned char> output = run(detector, image);
+
+            // Away from the top and bottom borders every row has the edge, at most 2 px wide
+            bool thin = true;
+            for (int y = 8; y < kHeight - 8; y++) {
+                int count = 0;
+                for (int x = 0; x < kWidth; x++) {
+                    if (output[(size_t)y * kWidth + x] == 0) continue;
+                    count++;
+                    if (x < 99 || x > 102) thin = false;
+                }
+                if (count < 1 || count > 2) thin = false;
+            }
+            CHECK(thin);
+        }
+    }
+}
+
+void testPoolMatchesSingleThread() {
+    std::vector<unsigned char> image = makeNoise();
+    WorkerPool pool(3);
+    const ScaleMergeMode modes[] = {kMergeMax, kMergeVote};
+    for (ScaleMergeMode mode : modes) {
+        for (int levels = 1; levels <= kMaxScaleLevels; levels++) {
+            EdgeDetector single;
+            single.setScaleLevels(levels, mode);
+            single.setThresholdMode(kThresholdOtsu);
+            EdgeDetector pooled;
+            pooled.setWorkerPool(&pool);
+            pooled.setScaleLevels(levels, mode);
+            pooled.setThresholdMode(kThresholdOtsu);
+            CHECK(run(single, image) == run(pooled, image));
+        }
+    }
+}
+
+// Scale settings flip from another thread while frames are processed; each frame must
+// match one of the two configurations. Most useful in a -fsanitize=thread build.
+void testSettingsChangeMidStream() {
+    std::vector<unsigned char> image = makeNoise();
+    std::vector<unsigned char> allowed[2];
+    for (int i = 0; i < 2; i++) {
+        EdgeDetector reference;
+        reference.setScaleLevels(i == 0 ? 1 : 3, i == 0 ? kMergeMax : kMergeVote);
+        reference.setThresholdMode(kThresholdPercentile, 80.0f);
+        allowed[i] = run(reference, image);
+    }
+    CHECK(allowed[0] != allowed[1]);
+
+    WorkerPool pool(2);
+    EdgeDetector detector;
+    detector.setWorkerPool(&pool);
+    detector.setThresholdMode(kThresholdPercentile, 80.0f);
+    std::atomic<bool> done(false);
+    std::thread flipper([&]() {
+        for (int i = 0; !done.load(); i++) {
+            detector.setScaleLevels(i % 2 == 0 ? 1 : 3, i % 2 == 0 ? kMergeMax : kMergeVote);
+            std::this_thread::yield();
+        }
+    });
+
+    int mismatches = 0;
+    for (int frame = 0; frame < 200; frame++) {
+        std::vector<unsigned char> output = run(detector, image);
+        if (output != allowed[0] && output != allowed[1]) mismatches++;
+    }
+    done = true;
+    flipper.join();
+    CHECK(mismatches == 0);
+}
+
+} // namespace
+
+int main() {
+    testStepStaysThin();
+    testPoolMatchesSingleThread();
+    testSettingsChangeMidStream();
+    return testResult();
+}
@@ -0,0 +1,156 @@
+// Round-trips edge recordings through the .edgr helpers and RecordingReader, with and
+// without the trailing index that FrameRecorder writes on close.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "../edge_recording.h"
+#include "../recording_reader.h"
+#include "test_util.h"
+
+namespace {
+
+const int kWidth = 40;
+const int kHeight = 24;
+
+// Mostly-zero frame with a few edge runs that move with `seed`
+std::vector<uint8_t> makeEdgeFrame(int seed) {
+    std::vector<uint8_t> pixels((size_t)kWidth * kHeight, 0);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        if ((i + seed) % 13 < 2) {
+            pixels[i] = (uint8_t)(seed * 7 + i);
+            if (pixels[i] == 0) pixels[i] = 1;
+        }
+    }
+    return pixels;
+}
+
+void testRleRoundTrip() {
+    std::vector<uint8_t> frames[] = {
+        std::vector<uint8_t>(kWidth * kHeight, 0),   // empty
+        std::vector<uint8_t>(kWidth * kHeight, 255), // no zeros at all
+        makeEdgeFrame(3),
+    };
+    for (const std::vector<uint8_t>& pixels : frames) {
+        std::vector<uint8_t> encoded(edgeRleBound(pixels.size()));
+        size_t size = encodeEdgeRle(pixels.data(), pixels.size(), encoded.data());
+        CHECK(size <= encoded.size());
+        std::vector<uint8_t> decoded(pixels.size());
+        CHECK(decodeEdgeRle(encoded.data(), size, decoded.data(), decoded.size()));
+        CHECK(decoded == pixels);
+        // A payload that covers too few pixels must be rejected
+        CHECK(!decodeEdgeRle(encoded.data(), size, decoded.data(), decoded.size() + 1));
+    }
+
+    // Truncated varint
+    uint8_t truncated[] = {0x80};
+    uint8_t pixel;
+    CHECK(!decodeEdgeRle(truncated, sizeof(truncated), &pixel, 1));
+}
+
+// Writes `frameCount` frames the way FrameRecorder does; the index is optional
+void writeRecording(const std::string& path, int frameCount, bool withIndex) {
+    FILE* file = fopen(path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file == nullptr) return;
+
+    RecordingFileHeader header = {};
+    memcpy(header.magic, kRecordingFileMagic, sizeof(header.magic));
+    header.version = kRecordingVersion;
+    header.width = kWidth;
+    header.height = kHeight;
+    fwrite(&header, sizeof(header), 1, file);
+
+    std::vector<RecordingIndexEntry> index;
+    uint64_t offset = sizeof(header);
+    for (int n = 0; n < frameCount; n++) {
+        std::vector<uint8_t> pixels = makeEdgeFrame(n);
+        std::vector<uint8_t> payload(edgeRleBound(pixels.size()));
+        RecordingFrameHeader frameHeader = {};
+        memcpy(frameHeader.magic, kRecordingFrameMagic, sizeof(frameHeader.magic));
+        frameHeader.width = kWidth;
+        frameHeader.height = kHeight;
+        frameHeader.stride = kWidth;
+        frameHeader.timestampNs = 1000000LL * n;
+        // Alternate encodings so the reader's raw path is covered too
+        if (n % 2 == 0) {
+            frameHeader.encoding = kEncodingEdgeRle;
+            frameHeader.payloadSize = (uint32_t)encodeEdgeRle(pixels.data(), pixels.size(), payload.data());
+        } else {
+            frameHeader.encoding = kEncodingRaw;
+            frameHeader.payloadSize = (uint32_t)pixels.size();
+            memcpy(payload.data(), pixels.data(), pixels.size());
+        }
+        fwrite(&frameHeader, sizeof(frameHeader), 1, file);
+        fwrite(payload.data(), 1, frameHeader.payloadSize, file);
+        index.push_back({offset, frameHeader.timestampNs});
+        offset += sizeof(frameHeader) + frameHeader.payloadSize;
+    }
+
+    if (withIndex) {
+        fwrite(index.data(), sizeof(RecordingIndexEntry), index.size(), file);
+        header.frameCount = (uint32_t)index.size();
+        header.indexOffset = offset;
+        fseek(file, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, file);
+    }
+    fclose(file);
+}
+
+void checkFrames(RecordingReader& reader, int frameCount) {
+    CHECK(reader.getFrameCount() == (size_t)frameCount);
+    RecordingReader::Frame frame;
+    for (int n = 0; n < (int)reader.getFrameCount(); n++) {
+        CHECK(reader.readFrame(n, frame));
+        CHECK(frame.width == kWidth && frame.height == kHeight && frame.stride == kWidth);
+        CHECK(frame.timestampNs == 1000000LL * n);
+        CHECK(frame.pixels == makeEdgeFrame(n));
+    }
+}
+
+void testReaderWithIndex() {
+    writeRecording("indexed.edgr", 9, true);
+    RecordingReader reader;
+    CHECK(reader.open("indexed.edgr"));
+    checkFrames(reader, 9);
+    RecordingReader::Frame frame;
+    CHECK(!reader.readFrame(9, frame));
+}
+
+void testReaderScanFallback() {
+    // Never closed: no index, and the last frame's payload was cut off
+    writeRecording("unclosed.edgr", 6, false);
+    FILE* file = fopen("unclosed.edgr", "r+b");
+    CHECK(file != nullptr);
+    if (file == nullptr) return;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    CHECK(truncate("unclosed.edgr", size - 5) == 0);
+
+    RecordingReader reader;
+    CHECK(reader.open("unclosed.edgr"));
+    checkFrames(reader, 5);
+}
+
+void testRejectsOtherFiles() {
+    FILE* file = fopen("not_a_recording.edgr", "wb");
+    fputs("P5\n1 1\n255\n", file);
+    fclose(file);
+    RecordingReader reader;
+    CHECK(!reader.open("not_a_recording.edgr"));
+    CHECK(!reader.open("missing.edgr"));
+}
+
+} // namespace
+
+int main() {
+    testRleRoundTrip();
+    testReaderWithIndex();
+    testReaderScanFallback();
+    testRejectsOtherFiles();
+    return testResult();
+}
@@ -0,0 +1,120 @@
+// Strip processing must give the same edge map as running EdgeDetector on the whole
+// frame, for any strip height and thread count.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../edge_detector.h"
+#include "../strip_processor.h"
+#include "../worker_pool.h"
+#include "test_util.h"
+
+namespace {
+
+bool writeFile(const std::string& path, const std::string& header, const std::vector<unsigned char>& pixels) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    fwrite(header.data(), 1, header.size(), file);
+    fwrite(pixels.data(), 1, pixels.size(), file);
+    return fclose(file) == 0;
+}
+
+std::vector<unsigned char> readFile(const std::string& path) {
+    std::vector<unsigned char> data;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return data;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        data.push_back((unsigned char)c);
+    }
+    fclose(file);
+    return data;
+}
+
+// Blocks and a diagonal with noise, so every kernel direction and border is exercised
+std::vector<unsigned char> makeImage(int width, int height) {
+    std::vector<unsigned char> pixels((size_t)width * height);
+    srand(7);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int base = ((x / 23 + y / 17) % 2) ? 190 : 60;
+            if (std::abs(x - 2 * y) < 3) base = 240;
+            pixels[(size_t)y * width + x] = (unsigned char)(base + rand() % 21 - 10);
+        }
+    }
+    return pixels;
+}
+
+void testStripsMatchWholeFrame() {
+    const int width = 211;
+    const int height = 157;
+    std::vector<unsigned char> image = makeImage(width, height);
+    std::string header = "P5\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    CHECK(writeFile("strip_input.pgm", header, image));
+
+    std::vector<unsigned char> expected(image.size());
+    EdgeDetector detector;
+    detector.process(image.data(), width, expected.data(), width, width, height);
+
+    const int stripRows[] = {1, 5, 64, 156, 157, 0};
+    const int threadCounts[] = {1, 3};
+    for (int threads : threadCounts) {
+        WorkerPool pool(threads);
+        for (int rows : stripRows) {
+            StripOptions options;
+            options.stripRows = rows;
+            std::string error;
+            CHECK(processImageFileInStrips("strip_input.pgm", "strip_output.pgm", options, pool, error));
+
+            std::vector<unsigned char> output = readFile("strip_output.pgm");
+            CHECK(output.size() == header.size() + image.size());
+            if (output.size() != header.size() + image.size()) continue;
+            CHECK(std::string(output.begin(), output.begin() + header.size()) == header);
+            CHECK(std::vector<unsigned char>(output.begin() + header.size(), output.end()) == expected);
+        }
+    }
+}
+
+void testRawInput() {
+    const int width = 64;
+    const int height = 40;
+    std::vector<unsigned char> image = makeImage(width, height);
+    CHECK(writeFile("strip_input.raw", "", image));
+
+    std::vector<unsigned char> expected(image.size());
+    EdgeDetector detector;
+    detector.process(image.data(), width, expected.data(), width, width, height);
+
+    WorkerPool pool(2);
+    StripOptions options;
+    options.width = width;
+    options.height = height;
+    options.stripRows = 9;
+    std::string error;
+    CHECK(processImageFileInStrips("strip_input.raw", "strip_output.raw", options, pool, error));
+    CHECK(readFile("strip_output.raw") == expected);
+
+    // Raw input without dimensions is an error, not a guess
+    CHECK(!processImageFileInStrips("strip_input.raw", "strip_output.raw", StripOptions(), pool, error));
+}
+
+void testRejectsUnsupportedPgm() {
+    WorkerPool pool(1);
+    std::string error;
+    CHECK(writeFile("strip_maxval.pgm", "P5\n4 4\n15\n", std::vector<unsigned char>(16, 3)));
+    CHECK(!processImageFileInStrips("strip_maxval.pgm", "strip_output.pgm", StripOptions(), pool, error));
+    CHECK(error.find("maxval") != std::string::npos);
+
+    CHECK(writeFile("strip_short.pgm", "P5\n8 8\n255\n", std::vector<unsigned char>(10, 3)));
+    CHECK(!processImageFileInStrips("strip_short.pgm", "strip_output.pgm", StripOptions(), pool, error));
+}
+
+} // namespace
+
+int main() {
+    testStripsMatchWholeFrame();
+    testRawInput();
+    testRejectsUnsupportedPgm();
+    return testResult();
+}
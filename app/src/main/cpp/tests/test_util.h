@@ -0,0 +1,30 @@
+#ifndef EDGEDETECTION_TEST_UTIL_H
+#define EDGEDETECTION_TEST_UTIL_H
+
+#include <cstdio>
+
+// Minimal checks for the host test executables: failures are printed and counted, and
+// main() returns testResult() so CTest sees a non-zero exit code.
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures()++;                                                     \
+        }                                                                         \
+    } while (0)
+
+inline int testResult() {
+    if (testFailures() == 0) {
+        printf("PASS\n");
+        return 0;
+    }
+    printf("FAIL (%d check(s))\n", testFailures());
+    return 1;
+}
+
+#endif // EDGEDETECTION_TEST_UTIL_H
@@ -0,0 +1,102 @@
+// Automatic threshold selection: thresholdsFromHistogram on synthetic histograms, and
+// the percentile setting as EdgeDetector applies it to a frame.
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "../edge_detector.h"
+#include "test_util.h"
+
+namespace {
+
+// The fixed mode's magnitude > 30, and the floor for automatic thresholds
+const int kFixedThreshold = 31;
+const int kAutoFloor = 8;
+
+void testFixed() {
+    uint32_t histogram[kHistogramBins] = {};
+    histogram[200] = 1000;
+    EdgeThresholds thresholds = thresholdsFromHistogram(histogram, kThresholdFixed, 90.0f);
+    CHECK(thresholds.low == kFixedThreshold && thresholds.high == kFixedThreshold);
+}
+
+void testOtsu() {
+    uint32_t histogram[kHistogramBins] = {};
+    histogram[10] = 1000;
+    histogram[200] = 1000;
+    EdgeThresholds thresholds = thresholdsFromHistogram(histogram, kThresholdOtsu, 0.0f);
+    CHECK(thresholds.high > 10 && thresholds.high <= 200);
+    CHECK(thresholds.low == thresholds.high / 2);
+
+    // Everything near zero: the split would sit at 1, the floor keeps noise out
+    uint32_t dark[kHistogramBins] = {};
+    dark[0] = 5000;
+    dark[1] = 5000;
+    thresholds = thresholdsFromHistogram(dark, kThresholdOtsu, 0.0f);
+    CHECK(thresholds.high == kAutoFloor && thresholds.low == kAutoFloor / 2);
+
+    // An empty frame falls back to the fixed threshold
+    uint32_t empty[kHistogramBins] = {};
+    thresholds = thresholdsFromHistogram(empty, kThresholdOtsu, 0.0f);
+    CHECK(thresholds.high == kFixedThreshold);
+}
+
+void testPercentile() {
+    uint32_t histogram[kHistogramBins] = {};
+    for (int i = 0; i < 100; i++) {
+        histogram[i] = 100;
+    }
+    EdgeThresholds thresholds = thresholdsFromHistogram(histogram, kThresholdPercentile, 50.0f);
+    CHECK(thresholds.high == 50 && thresholds.low == 25);
+    thresholds = thresholdsFromHistogram(histogram, kThresholdPercentile, 100.0f);
+    CHECK(thresholds.high == 100);
+    thresholds = thresholdsFromHistogram(histogram, kThresholdPercentile, 250.0f);
+    CHECK(thresholds.high == 100);
+    thresholds = thresholdsFromHistogram(histogram, kThresholdPercentile, 0.0f);
+    CHECK(thresholds.high == kAutoFloor);
+    thresholds = thresholdsFromHistogram(histogram, kThresholdPercentile, NAN);
+    CHECK(thresholds.high == 100);
+}
+
+// Thresholds EdgeDetector picked for a noisy frame with the given percentile
+EdgeThresholds frameThresholds(EdgeDetector& detector, const std::vector<unsigned char>& image,
+                               int width, int height) {
+    std::vector<unsigned char> output(image.size());
+    detector.process(image.data(), width, output.data(), width, width, height);
+    return detector.getLastThresholds();
+}
+
+void testDetectorPercentile() {
+    const int width = 96;
+    const int height = 64;
+    std::vector<unsigned char> image((size_t)width * height);
+    srand(3);
+    for (size_t i = 0; i < image.size(); i++) {
+        image[i] = (unsigned char)(rand() % 256);
+    }
+
+    EdgeDetector detector;
+    detector.setThresholdMode(kThresholdPercentile, 50.0f);
+    EdgeThresholds median = frameThresholds(detector, image, width, height);
+    detector.setThresholdMode(kThresholdPercentile, 99.0f);
+    EdgeThresholds top = frameThresholds(detector, image, width, height);
+    CHECK(top.high > median.high);
+
+    // A NaN from the UI keeps the previous percentile
+    detector.setThresholdMode(kThresholdPercentile, NAN);
+    EdgeThresholds afterNan = frameThresholds(detector, image, width, height);
+    CHECK(afterNan.high == top.high && afterNan.low == top.low);
+    detector.setThresholdMode(kThresholdPercentile, INFINITY);
+    afterNan = frameThresholds(detector, image, width, height);
+    CHECK(afterNan.high == top.high);
+}
+
+} // namespace
+
+int main() {
+    testFixed();
+    testOtsu();
+    testPercentile();
+    testDetectorPercentile();
+    return testResult();
+}
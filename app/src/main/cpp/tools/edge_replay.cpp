@@ -0,0 +1,490 @@
+// Replays a raw luma capture (NativeLib.startCapture) through the edge pipeline at the
+// cadence it was recorded with, and reports latency, dropped frames and deadline misses.
+//
+// Frames are handed to a single pipeline thread through a one-slot mailbox, the same way
+// CameraX's STRATEGY_KEEP_ONLY_LATEST feeds ImageAnalysis: a frame that is still waiting
+// when the next one arrives is dropped. Latency is measured from the frame's scheduled
+// arrival time to the end of processing.
+//
+// Only a small window of decoded frames is kept in memory; a reader thread decodes ahead
+// of the scheduler, so captures of any length can be replayed.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../edge_detector.h"
+#include "../recording_reader.h"
+#include "../worker_pool.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// Decoded frames kept ahead of the scheduler; 32 raw 1080p planes are about 64 MB
+const size_t kReplayWindowFrames = 32;
+
+struct Options {
+    std::string capturePath;
+    std::string thresholdsPath;
+    int loadThreads = 0;
+    int processEvery = 1;
+    int loops = 1;
+    // One per core, like the WorkerPool initProcessor creates
+    int pipelineThreads = 0;
+    int scaleLevels = 1;
+    ScaleMergeMode mergeMode = kMergeMax;
+    ThresholdMode thresholdMode = kThresholdFixed;
+    float thresholdPercentile = 90.0f;
+    double deadlineMs = 0.0;
+};
+
+struct Stats {
+    size_t framesDelivered = 0;
+    size_t framesDropped = 0;
+    size_t deadlineMisses = 0;
+    size_t readerStalls = 0;
+    std::vector<double> latenciesMs;
+};
+
+// Ring of decoded frames filled by a reader thread. Replay position `sequence` is capture
+// frame sequence % frameCount, so looping just keeps reading. A slot is only refilled once
+// the frame in it has been released, by whichever of the scheduler (skipped frames), the
+// mailbox (dropped frames) or the pipeline (processed frames) was the last to hold it.
+class FrameWindow {
+public:
+    FrameWindow(RecordingReader& reader, size_t frameCount, size_t sequenceCount)
+            : reader(reader), frameCount(frameCount), sequenceCount(sequenceCount),
+              slots(std::min(kReplayWindowFrames, sequenceCount)), stopping(false), failed(false), stalls(0) {
+        for (Slot& slot : slots) {
+            slot.sequence = kEmpty;
+            slot.inUse = false;
+        }
+        readerThread = std::thread(&FrameWindow::readerLoop, this);
+    }
+
+    ~FrameWindow() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        readerThread.join();
+    }
+
+    // Blocks until the window is full, so the replay starts with frames in memory
+    bool prefill() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return waitLoaded(lock, slots.size() - 1);
+    }
+
+    // Blocks until frame `sequence` is decoded; nullptr if the capture could not be read
+    const RecordingReader::Frame* acquire(size_t sequence) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!isLoaded(sequence)) {
+            // Decoding fell behind the recorded cadence; arrivals slip until it catches up
+            stalls++;
+        }
+        return waitLoaded(lock, sequence) ? &slots[sequence % slots.size()].frame : nullptr;
+    }
+
+    void release(size_t sequence) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slot& slot = slots[sequence % slots.size()];
+            if (slot.sequence == sequence) {
+                slot.inUse = false;
+            }
+        }
+        condition.notify_all();
+    }
+
+    size_t getStalls() const { return stalls; }
+    const std::string& getError() const { return error; }
+
+private:
+    static const size_t kEmpty = (size_t)-1;
+
+    struct Slot {
+        RecordingReader::Frame frame;
+        size_t sequence;
+        bool inUse;
+    };
+
+    RecordingReader& reader;
+    size_t frameCount;
+    size_t sequenceCount;
+    std::vector<Slot> slots;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+    bool failed;
+    size_t stalls;
+    std::string error;
+    std::thread readerThread;
+
+    bool isLoaded(size_t sequence) const {
+        return slots[sequence % slots.size()].sequence == sequence;
+    }
+
+    bool waitLoaded(std::unique_lock<std::mutex>& lock, size_t sequence) {
+        condition.wait(lock, [&] { return isLoaded(sequence) || failed; });
+        return !failed;
+    }
+
+    void readerLoop() {
+        for (size_t sequence = 0; sequence < sequenceCount; sequence++) {
+            Slot& slot = slots[sequence % slots.size()];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&] { return !slot.inUse || stopping; });
+                if (stopping) {
+                    return;
+                }
+                slot.sequence = kEmpty;
+            }
+
+            // The slot is free and marked empty, so decode into it without the lock
+            bool ok = reader.readFrame(sequence % frameCount, slot.frame);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ok) {
+                    slot.sequence = sequence;
+                    slot.inUse = true;
+                } else {
+                    error = "frame " + std::to_string(sequence % frameCount) + ": " + reader.getLastError();
+                    failed = true;
+                }
+            }
+            condition.notify_all();
+            if (!ok) {
+                return;
+            }
+        }
+    }
+};
+
+void printUsage() {
+    fprintf(stderr,
+            "Usage: edge-replay <capture.edgr> [options]\n"
+            "  --load <threads>      run background CPU load on this many threads (default 0)\n"
+            "  --process-every <n>   hand every n-th camera frame to the pipeline (default 1)\n"
+            "  --deadline-ms <ms>    per-frame latency budget (default: frame interval)\n"
+            "  --loops <n>           replay the capture n times (default 1)\n"
+            "  --threads <n>         pipeline worker threads, 0 = one per core (default 0)\n"
+            "  --scales <n>          multi-scale pyramid levels, 1-4 (default 1)\n"
+            "  --merge <max|vote>    how pyramid levels are merged (default max)\n"
+            "  --edge-threshold <fixed|otsu|pNN>\n"
+            "                        per-frame edge thresholds, pNN = NN-th percentile (default fixed)\n"
+            "  --thresholds <file>   fail the run if it exceeds any limit in <file>\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--load" && hasValue) {
+            options.loadThreads = atoi(argv[++i]);
+        } else if (arg == "--process-every" && hasValue) {
+            options.processEvery = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--deadline-ms" && hasValue) {
+            options.deadlineMs = atof(argv[++i]);
+        } else if (arg == "--loops" && hasValue) {
+            options.loops = std::max(1, atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.pipelineThreads = atoi(argv[++i]);
+        } else if (arg == "--scales" && hasValue) {
+            options.scaleLevels = atoi(argv[++i]);
+        } else if (arg == "--merge" && hasValue) {
+            std::string mode = argv[++i];
+            if (mode != "max" && mode != "vote") return false;
+            options.mergeMode = mode == "vote" ? kMergeVote : kMergeMax;
+        } else if (arg == "--edge-threshold" && hasValue) {
+            std::string mode = argv[++i];
+            if (mode == "fixed") {
+                options.thresholdMode = kThresholdFixed;
+            } else if (mode == "otsu") {
+                options.thresholdMode = kThresholdOtsu;
+            } else if (mode.size() > 1 && mode[0] == 'p') {
+                options.thresholdMode = kThresholdPercentile;
+                options.thresholdPercentile = (float)atof(mode.c_str() + 1);
+            } else {
+                return false;
+            }
+        } else if (arg == "--thresholds" && hasValue) {
+            options.thresholdsPath = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-' && options.capturePath.empty()) {
+            options.capturePath = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.capturePath.empty();
+}
+
+// Same steps as processFrameData (with the default --threads): edge detection into a fresh output array
+void runPipeline(EdgeDetector& detector, const RecordingReader::Frame& frame) {
+    std::vector<unsigned char> outputBuffer((size_t)frame.width * frame.height);
+    detector.process(frame.pixels.data(), frame.stride, outputBuffer.data(), frame.width, frame.width, frame.height);
+}
+
+void burnCpu(const std::atomic<bool>& stop) {
+    volatile double sink = 1.0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 10000; i++) {
+            sink = sink * 1.0000001 + 1e-9;
+        }
+    }
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+Stats replay(FrameWindow& window, const std::vector<int64_t>& timestamps, const Options& options, double deadlineMs) {
+    Stats stats;
+
+    std::mutex mailboxMutex;
+    std::condition_variable mailboxCondition;
+    const RecordingReader::Frame* pendingFrame = nullptr;
+    size_t pendingSequence = 0;
+    Clock::time_point pendingArrival;
+    bool finished = false;
+
+    std::thread pipeline([&] {
+        WorkerPool pool(options.pipelineThreads);
+        EdgeDetector detector;
+        detector.setWorkerPool(&pool);
+        detector.setScaleLevels(options.scaleLevels, options.mergeMode);
+        detector.setThresholdMode(options.thresholdMode, options.thresholdPercentile);
+        while (true) {
+            const RecordingReader::Frame* frame;
+            size_t sequence;
+            Clock::time_point arrival;
+            {
+                std::unique_lock<std::mutex> lock(mailboxMutex);
+                mailboxCondition.wait(lock, [&] { return pendingFrame != nullptr || finished; });
+                if (pendingFrame == nullptr) {
+                    return;
+                }
+                frame = pendingFrame;
+                sequence = pendingSequence;
+                arrival = pendingArrival;
+                pendingFrame = nullptr;
+            }
+
+            runPipeline(detector, *frame);
+            window.release(sequence);
+
+            double latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - arrival).count();
+            stats.latenciesMs.push_back(latencyMs);
+            if (latencyMs > deadlineMs) {
+                stats.deadlineMisses++;
+            }
+        }
+    });
+
+    size_t sequence = 0;
+    bool readFailed = false;
+    for (int loop = 0; loop < options.loops && !readFailed; loop++) {
+        Clock::time_point loopStart = Clock::now();
+        int64_t firstTimestamp = timestamps.front();
+        for (size_t i = 0; i < timestamps.size(); i++, sequence++) {
+            const RecordingReader::Frame* frame = window.acquire(sequence);
+            if (frame == nullptr) {
+                readFailed = true;
+                break;
+            }
+            Clock::time_point arrival = loopStart + std::chrono::nanoseconds(timestamps[i] - firstTimestamp);
+            std::this_thread::sleep_until(arrival);
+
+            // The analyzer only processes every n-th frame; the rest are skipped on purpose
+            if (sequence % options.processEvery != 0) {
+                window.release(sequence);
+                continue;
+            }
+
+            stats.framesDelivered++;
+            {
+                std::lock_guard<std::mutex> lock(mailboxMutex);
+                if (pendingFrame != nullptr) {
+                    // Pipeline still busy with an older frame; newest frame replaces the waiting one
+                    stats.framesDropped++;
+                    window.release(pendingSequence);
+                }
+                pendingFrame = frame;
+                pendingSequence = sequence;
+                pendingArrival = arrival;
+            }
+            mailboxCondition.notify_one();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mailboxMutex);
+        finished = true;
+    }
+    mailboxCondition.notify_one();
+    pipeline.join();
+    stats.readerStalls = window.getStalls();
+    return stats;
+}
+
+bool loadThresholds(const std::string& path, std::map<std::string, double>& thresholds) {
+    static const char* kKnownKeys[] = {
+        "max_p50_ms", "max_p90_ms", "max_p99_ms", "max_latency_ms",
+        "max_dropped_frames", "max_dropped_percent", "max_deadline_misses",
+    };
+
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot open thresholds file: %s\n", path.c_str());
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::replace(line.begin(), line.end(), '=', ' ');
+        std::istringstream fields(line);
+        std::string key;
+        double value;
+        if (!(fields >> key)) {
+            continue;
+        }
+        bool known = std::find_if(std::begin(kKnownKeys), std::end(kKnownKeys),
+                                  [&](const char* k) { return key == k; }) != std::end(kKnownKeys);
+        if (!known || !(fields >> value)) {
+            fprintf(stderr, "%s:%d: invalid threshold '%s'\n", path.c_str(), lineNumber, key.c_str());
+            return false;
+        }
+        thresholds[key] = value;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    std::map<std::string, double> thresholds;
+    if (!options.thresholdsPath.empty() && !loadThresholds(options.thresholdsPath, thresholds)) {
+        return 1;
+    }
+
+    RecordingReader reader;
+    if (!reader.open(options.capturePath)) {
+        fprintf(stderr, "Failed to open capture: %s\n", reader.getLastError().c_str());
+        return 1;
+    }
+    std::vector<int64_t> timestamps(reader.getFrameCount());
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        timestamps[i] = reader.getFrameTimestamp(i);
+    }
+    if (timestamps.size() < 2) {
+        fprintf(stderr, "Capture needs at least two frames to establish a cadence\n");
+        return 1;
+    }
+
+    std::vector<double> intervalsMs;
+    for (size_t i = 1; i < timestamps.size(); i++) {
+        intervalsMs.push_back((timestamps[i] - timestamps[i - 1]) / 1e6);
+    }
+    std::sort(intervalsMs.begin(), intervalsMs.end());
+    double frameIntervalMs = percentile(intervalsMs, 50);
+    double deadlineMs = options.deadlineMs > 0 ? options.deadlineMs : frameIntervalMs * options.processEvery;
+
+    printf("capture: %s, %zu frames, %dx%d, %.1f fps\n", options.capturePath.c_str(), timestamps.size(),
+           reader.getWidth(), reader.getHeight(), frameIntervalMs > 0 ? 1000.0 / frameIntervalMs : 0.0);
+    printf("replay: %d loop(s), every %d frame(s), %d load thread(s), deadline %.2f ms\n",
+           options.loops, options.processEvery, options.loadThreads, deadlineMs);
+    if (options.pipelineThreads <= 0) {
+        // Same rule as WorkerPool, so the printed count is the one used
+        options.pipelineThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    }
+    printf("pipeline: %d thread(s), %d scale level(s), edge threshold mode %d\n", options.pipelineThreads,
+           options.scaleLevels, options.thresholdMode);
+
+    // Fill the decode window before the clock starts so the first frames are not late
+    FrameWindow window(reader, timestamps.size(), timestamps.size() * options.loops);
+    if (!window.prefill()) {
+        fprintf(stderr, "Failed to read capture: %s\n", window.getError().c_str());
+        return 1;
+    }
+
+    std::atomic<bool> stopLoad(false);
+    std::vector<std::thread> loadThreads;
+    for (int i = 0; i < options.loadThreads; i++) {
+        loadThreads.emplace_back(burnCpu, std::cref(stopLoad));
+    }
+
+    Stats stats = replay(window, timestamps, options, deadlineMs);
+
+    stopLoad = true;
+    for (std::thread& thread : loadThreads) {
+        thread.join();
+    }
+    if (!window.getError().empty()) {
+        fprintf(stderr, "Failed to read capture: %s\n", window.getError().c_str());
+        return 1;
+    }
+
+    std::vector<double> sorted = stats.latenciesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double meanMs = 0.0;
+    for (double latency : sorted) {
+        meanMs += latency;
+    }
+    meanMs = sorted.empty() ? 0.0 : meanMs / sorted.size();
+    double droppedPercent = stats.framesDelivered > 0 ? 100.0 * stats.framesDropped / stats.framesDelivered : 0.0;
+
+    std::map<std::string, double> measured = {
+        {"max_p50_ms", percentile(sorted, 50)},
+        {"max_p90_ms", percentile(sorted, 90)},
+        {"max_p99_ms", percentile(sorted, 99)},
+        {"max_latency_ms", sorted.empty() ? 0.0 : sorted.back()},
+        {"max_dropped_frames", (double)stats.framesDropped},
+        {"max_dropped_percent", droppedPercent},
+        {"max_deadline_misses", (double)stats.deadlineMisses},
+    };
+
+    printf("frames: %zu delivered, %zu processed, %zu dropped (%.1f%%)\n",
+           stats.framesDelivered, sorted.size(), stats.framesDropped, droppedPercent);
+    printf("latency ms: mean %.2f  p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n", meanMs,
+           measured["max_p50_ms"], measured["max_p90_ms"], measured["max_p99_ms"], measured["max_latency_ms"]);
+    printf("deadline misses: %zu\n", stats.deadlineMisses);
+    if (stats.readerStalls > 0) {
+        printf("reader stalls: %zu (capture decoded slower than recorded)\n", stats.readerStalls);
+    }
+
+    int failures = 0;
+    for (const auto& threshold : thresholds) {
+        double value = measured[threshold.first];
+        if (value > threshold.second) {
+            printf("FAIL %s: %.2f > %.2f\n", threshold.first.c_str(), value, threshold.second);
+            failures++;
+        }
+    }
+    if (!thresholds.empty()) {
+        printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+    }
+    return failures == 0 ? 0 : 2;
+}
@@ -0,0 +1,67 @@
+// Runs the edge pipeline over very large PGM or raw Y8 images in horizontal strips,
+// using memory-mapped input and output files (see strip_processor.h).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "../strip_processor.h"
+#include "../worker_pool.h"
+
+namespace {
+
+void printUsage() {
+    fprintf(stderr,
+            "Usage: edge-strips <input.pgm|input.raw> <output> [options]\n"
+            "  --width <px> --height <px>   dimensions of a raw Y8 input\n"
+            "  --threads <n>                worker threads (default: one per core)\n"
+            "  --strip-rows <n>             output rows per strip (default: from width)\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string inputPath;
+    std::string outputPath;
+    StripOptions options;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue) {
+            options.width = atoi(argv[++i]);
+        } else if (arg == "--height" && hasValue) {
+            options.height = atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (arg == "--strip-rows" && hasValue) {
+            options.stripRows = atoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] != '-' && inputPath.empty()) {
+            inputPath = arg;
+        } else if (!arg.empty() && arg[0] != '-' && outputPath.empty()) {
+            outputPath = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    if (inputPath.empty() || outputPath.empty()) {
+        printUsage();
+        return 1;
+    }
+
+    WorkerPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+
+    std::string error;
+    if (!processImageFileInStrips(inputPath, outputPath, options, pool, error)) {
+        fprintf(stderr, "edge-strips: %s\n", error.c_str());
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%s -> %s in %.2f s on %d thread(s)\n", inputPath.c_str(), outputPath.c_str(), seconds,
+           pool.getThreadCount());
+    return 0;
+}
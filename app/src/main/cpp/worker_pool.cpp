@@ -0,0 +1,82 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool(int threadCount) : currentTask(nullptr), taskCount(0), nextIndex(0),
+                                          activeWorkers(0), generation(0), shuttingDown(false) {
+    if (threadCount <= 0) {
+        threadCount = (int)std::thread::hardware_concurrency();
+    }
+    this->threadCount = threadCount > 0 ? threadCount : 1;
+
+    for (int worker = 1; worker < this->threadCount; worker++) {
+        threads.emplace_back(&WorkerPool::workerLoop, this, worker);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shuttingDown = true;
+    }
+    startCondition.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(int count, const std::function<void(int, int)>& task) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1 || threads.empty()) {
+        for (int i = 0; i < count; i++) {
+            task(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTask = &task;
+        taskCount = count;
+        nextIndex.store(0);
+        activeWorkers = (int)threads.size();
+        generation++;
+    }
+    startCondition.notify_all();
+
+    runTasks(0);
+
+    // Wait for the other workers to finish their last index before `task` goes out of scope
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+    currentTask = nullptr;
+}
+
+void WorkerPool::workerLoop(int worker) {
+    unsigned seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&] { return shuttingDown || generation != seenGeneration; });
+            if (shuttingDown) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+
+        runTasks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        doneCondition.notify_one();
+    }
+}
+
+void WorkerPool::runTasks(int worker) {
+    const std::function<void(int, int)>& task = *currentTask;
+    for (int i = nextIndex.fetch_add(1); i < taskCount; i = nextIndex.fetch_add(1)) {
+        task(i, worker);
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef EDGEDETECTION_WORKER_POOL_H
+#define EDGEDETECTION_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run index-based parallel loops.
+// The calling thread takes part as worker 0, so a pool of N threads owns N - 1 of them.
+class WorkerPool {
+public:
+    // threadCount <= 0 uses one thread per hardware core
+    explicit WorkerPool(int threadCount = 0);
+    ~WorkerPool();
+
+    int getThreadCount() const { return threadCount; }
+
+    // Runs task(index, worker) for every index in [0, count) and returns once all are done.
+    // `worker` is in [0, getThreadCount()) and is stable for the duration of one call, so it
+    // can be used to pick per-thread scratch buffers. Not reentrant.
+    void parallelFor(int count, const std::function<void(int, int)>& task);
+
+private:
+    int threadCount;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    const std::function<void(int, int)>* currentTask;
+    int taskCount;
+    std::atomic<int> nextIndex;
+    int activeWorkers;
+    unsigned generation;
+    bool shuttingDown;
+
+    void workerLoop(int worker);
+    void runTasks(int worker);
+};
+
+#endif // EDGEDETECTION_WORKER_POOL_H
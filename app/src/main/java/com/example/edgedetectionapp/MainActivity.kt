@@ -26,6 +26,7 @@ import androidx.camera.lifecycle.ProcessCameraProvider
 import androidx.camera.view.PreviewView
 import androidx.core.app.ActivityCompat
 import androidx.core.content.ContextCompat
+import java.io.File
 import java.util.concurrent.ExecutorService
 import java.util.concurrent.Executors
 
@@ -84,6 +85,13 @@ class MainActivity : AppCompatActivity() {
             }
         }
         
+        // Long press toggles a raw capture for the edge-replay tool while the camera runs
+        startCameraButton.setOnLongClickListener {
+            if (isCameraStarted) {
+                toggleCapture()
+            }
+            isCameraStarted
+        }
 
         // Always show processed view
         processedImageView.visibility = View.VISIBLE
@@ -175,6 +183,19 @@ class MainActivity : AppCompatActivity() {
         }, ContextCompat.getMainExecutor(this))
     }
     
+    private fun toggleCapture() {
+        if (NativeLib.isCapturing()) {
+            val frames = NativeLib.endCapture()
+            val dropped = NativeLib.getCaptureDroppedFrames()
+            Toast.makeText(this, "Capture saved: $frames frames, $dropped dropped", Toast.LENGTH_LONG).show()
+        } else {
+            val file = File(getExternalFilesDir(null), "capture-${System.currentTimeMillis()}.edgr")
+            val started = NativeLib.beginCapture(file.absolutePath)
+            val message = if (started) "Capture starts with the next frame: ${file.name}" else "Capture failed to start"
+            Toast.makeText(this, message, Toast.LENGTH_SHORT).show()
+        }
+    }
+    
     private fun allPermissionsGranted() = REQUIRED_PERMISSIONS.all {
         ContextCompat.checkSelfPermission(baseContext, it) == PackageManager.PERMISSION_GRANTED
     }
@@ -209,6 +230,7 @@ class MainActivity : AppCompatActivity() {
     
     override fun onDestroy() {
         super.onDestroy()
+        NativeLib.endCapture()
         cameraExecutor.shutdown()
     }
     
@@ -218,6 +240,17 @@ class MainActivity : AppCompatActivity() {
         
         override fun analyze(image: ImageProxy) {
             frameCount++
+            if (NativeLib.isCapturing()) {
+                // Capture every camera frame, not just the processed ones, to keep the original cadence
+                val plane = image.planes[0]
+                val captured = NativeLib.captureFrame(plane.buffer, image.width, image.height, plane.rowStride, image.imageInfo.timestamp)
+                if (!captured && NativeLib.hasCaptureFailed()) {
+                    NativeLib.endCapture()
+                    runOnUiThread {
+                        Toast.makeText(this@MainActivity, "Capture failed to start", Toast.LENGTH_LONG).show()
+                    }
+                }
+            }
             runOnUiThread {
                 frameNumberText.text = "Frame: $frameCount"
             }
@@ -1,10 +1,16 @@
 package com.example.edgedetectionapp
 
 import android.util.Log
+import java.nio.ByteBuffer
 
 object NativeLib {
     private var isNativeLoaded = false
     private var isProcessorInitialized = false
+    // Capture states reported by getCaptureState; keep in sync with native-lib.cpp
+    const val CAPTURE_IDLE = 0
+    const val CAPTURE_ARMED = 1
+    const val CAPTURE_RUNNING = 2
+    const val CAPTURE_FAILED = 3
     
     init {
         try {
@@ -37,12 +43,53 @@ object NativeLib {
     
     fun isLibraryLoaded(): Boolean = isNativeLoaded
     fun isProcessorReady(): Boolean = isProcessorInitialized
+    // Armed counts as capturing: the analyzer must keep passing frames until the first one starts it
+    fun isCapturing(): Boolean {
+        if (!isNativeLoaded) return false
+        val state = getCaptureState()
+        return state == CAPTURE_ARMED || state == CAPTURE_RUNNING
+    }
+    
+    // The recorder could not be started with the first frame; endCapture() resets it
+    fun hasCaptureFailed(): Boolean = isNativeLoaded && getCaptureState() == CAPTURE_FAILED
+    
+    // Records raw camera luma planes for replay with the host-side edge-replay tool.
+    // The size and row stride are taken from the first frame passed to captureFrame.
+    fun beginCapture(path: String): Boolean {
+        if (!isNativeLoaded) return false
+        val armed = startCapture(path, 8)
+        Log.d("NativeLib", "Capture ${if (armed) "armed" else "failed"}: $path")
+        return armed
+    }
+    
+    fun endCapture(): Int {
+        if (!isNativeLoaded || getCaptureState() == CAPTURE_IDLE) return 0
+        val frames = stopCapture()
+        val dropped = getCaptureDroppedFrames()
+        if (dropped > 0) {
+            Log.w("NativeLib", "Capture finished: $frames frames, $dropped dropped")
+        } else {
+            Log.d("NativeLib", "Capture finished: $frames frames")
+        }
+        return frames
+    }
 
     external fun stringFromJNI(): String
     external fun initProcessor()
     external fun processFrame(matAddr: Long, applyEdgeDetection: Boolean): Long
     external fun processFrameData(imageData: ByteArray, width: Int, height: Int, applyEdgeDetection: Boolean): ByteArray?
     external fun releaseProcessor()
+    // levels: 1 (single scale) to 4; mergeMode: 0 = strongest level, 1 = majority vote
+    external fun setMultiScale(levels: Int, mergeMode: Int)
+    // mode: 0 = fixed threshold, 1 = Otsu, 2 = percentile (0-100) of each frame's gradients
+    external fun setAutoThreshold(mode: Int, percentile: Float)
+    external fun startRecording(path: String, width: Int, height: Int, queueDepth: Int): Boolean
+    external fun stopRecording(): Int
+    external fun startCapture(path: String, queueDepth: Int): Boolean
+    external fun captureFrame(lumaBuffer: ByteBuffer, width: Int, height: Int, rowStride: Int, timestampNs: Long): Boolean
+    external fun stopCapture(): Int
+    external fun getCaptureDroppedFrames(): Int
+    external fun getCaptureState(): Int
     external fun initRenderer(width: Int, height: Int)
     external fun renderFrame(matAddr: Long)
     external fun releaseRenderer()